@@ -0,0 +1,498 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#ifndef agi_h
+#define agi_h
+
+#include <SDL3/SDL.h>
+
+#define MAX_LOOPS 255
+#define MAX_CELS 255
+#define MAX_CEL_WIDTH 320   // SCI0; AGI cels are at most 255.
+#define MAX_CEL_HEIGHT 255
+
+extern const SDL_Color pal[16];
+
+
+
+typedef struct {
+    Uint16 header_offset;
+    Uint16 data_offset;
+    Uint16 width;
+    Uint16 height;
+    Uint8 transparency_color;
+    Uint8 is_mirrored;
+    Uint8 unmirrored_loop_num;
+} Cel;
+
+
+
+typedef struct {
+    Uint16 offset;
+    Uint8 num_cels;
+    Uint16 total_width;
+    Uint16 total_height;
+    Cel cels[MAX_CELS];
+} Loop;
+
+
+
+typedef enum {
+    SOURCE_SPAN,        // Part of another source.
+    SOURCE_OWNED,       // Memory freed on closing.
+    SOURCE_MAPPED,      // A memory-mapped file.
+    SOURCE_CACHED,      // A pinned file in the cache.
+} SourceKind;
+
+typedef struct CachedFile CachedFile;
+
+/// Immutable bytes that resources are read from. See source.c.
+typedef struct {
+    const Uint8 * data;
+    size_t size;
+    Uint64 id;          // Identity, stable until the underlying file changes.
+    SourceKind kind;
+    CachedFile * file;  // The cached file the bytes are in, if any, and
+    size_t offset;      // where.
+} Source;
+
+
+
+typedef enum {
+    VIEW_AGI,
+    VIEW_SCI0,
+} ViewFormat;
+
+
+
+typedef struct {
+    const Uint8 * data; // The raw View resource, not owned by the View.
+    size_t size;
+    Source source;      // Holds `data` in memory until ReleaseView.
+    Loop loops[MAX_LOOPS];
+    Uint8 num_loops;
+    ViewFormat format;
+    Uint8 pixel_width;  // Displayed width of a pixel: 2 for AGI, 1 for SCI0.
+    Uint64 deadline;    // SDL_GetTicksNS() by which decoding must end, or 0.
+} View;
+
+
+
+/// Every cel of a View, decoded to one color index per pixel.
+typedef struct {
+    const View * view;
+    Uint8 * pixels;
+    Uint8 ** cels;
+    int num_cels;
+    int first_cel[MAX_LOOPS]; // Index in `cels` of each loop's first cel.
+} DecodedView;
+
+#define GetDecodedCel(decoded, loop_num, cel_num) \
+    ((decoded)->cels[(decoded)->first_cel[loop_num] + (cel_num)])
+
+
+
+/// How far decoding a cel has got, for decoding it a few rows at a time.
+typedef struct {
+    const View * view;
+    const Cel * cel;
+    bool mirrored;
+    size_t pos;         // Next byte of the cel's data.
+    size_t end;         // End of the data the cel may read.
+    int y;              // Next row.
+    int run;            // SCI0: what's left of a run, which continues onto
+    Uint8 color;        // row `y`.
+    bool ok;            // False once the data is found to be malformed.
+} CelRows;
+
+
+
+typedef struct {
+    const SDL_Color * palette; // NULL for the default EGA palette.
+    int scale;
+    bool opaque;               // Fill the background instead of leaving it
+    SDL_Color background;      // transparent.
+} RenderOptions;
+
+
+
+#define MAX_PATH_LENGTH 512
+#define MAX_GAME_ID 8       // AGI v3 game IDs prefix file names, e.g. "KQ4".
+#define MAX_RESOURCE_NUMBER 0x800 // SCI0 numbers are 11 bits, AGI's 8.
+
+
+
+typedef enum {
+    RESOURCE_VIEW,
+    RESOURCE_PICTURE,
+} ResourceType;
+
+
+
+/// A View (or, with -pic, picture) resource found in one of the input paths.
+typedef struct {
+    char name[256];     // e.g. "VIEW.014" or "KQ1/VIEW.014", used for output.
+    int number;         // Number within its game, or -1 for loose files.
+    ViewFormat format;
+    const Uint8 * data; // NULL if in `file`; see LoadResource.
+    size_t size;
+    CachedFile * file;  // The cached file the resource is read from, and
+    size_t offset;      // where, or NULL if `data` is always in memory.
+    Uint64 key;         // Identity of the resource, for caching.
+    char inputs[2][MAX_PATH_LENGTH]; // Files read, e.g. VIEWDIR and VOL.1.
+    int num_inputs;
+} ViewResource;
+
+
+
+typedef struct {
+    ViewResource * views;
+    int num_views;
+    Source * sources;   // Files and memory backing the views' data.
+    int num_sources;
+} ViewList;
+
+
+
+//
+// view.c
+//
+
+typedef enum {
+    KERNEL_AUTO,    // Choose by cel width.
+    KERNEL_SCALAR,  // Expand one run at a time.
+    KERNEL_PREFIX,  // Prefix sum of run lengths, then write runs independently.
+} DecodeKernel;
+
+extern DecodeKernel decode_kernel;
+extern bool decode_bounded;         // Cap each cel's work by its size.
+extern Uint64 decode_timeout_ns;    // Per-View decode budget, or 0.
+
+bool ParseView(View * view, const Uint8 * data, size_t size);
+bool ParseViewResource(View * view, const ViewResource * resource);
+void ReleaseView(View * view);
+bool CelIsMirrored(const View * view, int loop_num, const Cel * cel);
+void StartCelRows(CelRows * rows, const View * view, int loop_num, int cel_num);
+int DecodeCelRows(CelRows * rows, int count, Uint8 * out, int pitch);
+bool DecodeCel(const View * view, int loop_num, int cel_num, Uint8 * out, int pitch);
+void DecodeCelReduced(const View * view,
+                      int loop_num,
+                      int cel_num,
+                      int shrink,
+                      Uint8 * out,
+                      int pitch);
+void BlitCel(SDL_Surface * s,
+             int x,
+             int y,
+             const Uint8 * pixels,
+             int w,
+             int h,
+             int pitch,
+             int transparency_color,
+             const SDL_Color * palette,
+             int x_scale,
+             int y_scale);
+bool AllocateDecodedView(DecodedView * decoded, const View * view);
+bool DecodeView(DecodedView * decoded, const View * view);
+void FreeDecodedView(DecodedView * decoded);
+SDL_Surface * RenderDecodedView(const DecodedView * decoded, const RenderOptions * options);
+SDL_Surface * RenderView(const View * view);
+
+//
+// decoder.c
+//
+
+/// Decodes a View a budget of rows or time at a time. See decoder.c.
+typedef struct {
+    DecodedView decoded;
+    CelRows rows;       // The cel being decoded.
+    int loop_num;
+    int cel_num;
+    int rows_done;      // Rows decoded in all, out of `total_rows`.
+    int total_rows;
+    bool done;
+} ViewDecoder;
+
+bool StartViewDecoder(ViewDecoder * decoder, const View * view);
+bool ContinueViewDecoder(ViewDecoder * decoder, int max_rows, Uint64 max_ns);
+int GetDecodedRows(const ViewDecoder * decoder, int loop_num, int cel_num);
+void FreeViewDecoder(ViewDecoder * decoder);
+
+//
+// source.c
+//
+
+Uint64 ResourceKey(Uint64 source_id, Uint64 offset, Uint64 size);
+Uint64 ContentKey(const Uint8 * data, size_t size);
+bool OpenSource(Source * source, const char * path);
+void OwnedSource(Source * source, void * data, size_t size, Uint64 id);
+void SpanSource(Source * source, const Source * parent, size_t offset, size_t size);
+void CloseSource(Source * source);
+bool OpenCachedSource(Source * source, const char * path);
+bool PinCachedFile(CachedFile * file, Source * source);
+void CloseSourceCache(void);
+
+//
+// game.c
+//
+
+/// Open a file from a game as a source, and set `path` to the file the data
+/// was actually read from.
+typedef bool (* GameFileFunc)(void * context,
+                              const char * name,
+                              Source * source,
+                              char * path); // MAX_PATH_LENGTH; file read.
+
+void AddSource(ViewList * list, Source * source);
+const Uint8 * AddBuffer(ViewList * list, void * buffer, size_t size, Uint64 id);
+void SetViewInputs(ViewResource * view, const char * input1, const char * input2);
+void SetViewData(ViewResource * view, const Uint8 * data, size_t size);
+void SetViewSource(ViewResource * view, const Source * source);
+bool LoadResource(const ViewResource * resource, Source * source);
+ViewResource * AddView(ViewList * list);
+bool GetV3GameID(const char * name, char * id);
+bool CollectGameResources(ViewList * list,
+                          const char * prefix,
+                          ResourceType type,
+                          const char * v3_id,
+                          GameFileFunc load,
+                          void * context);
+bool CollectResources(ViewList * list, const char * path, ResourceType type);
+bool CollectViews(ViewList * list, const char * path);
+void FreeViewList(ViewList * list);
+
+//
+// fat.c
+//
+
+typedef struct {
+    const Source * source; // Open while the image is used.
+    const Uint8 * data;
+    size_t size;
+    Uint64 id;
+    int bytes_per_cluster;
+    int fat_bits;
+    Uint32 num_clusters;
+    size_t fat_offset;
+    size_t root_offset;
+    int root_entries;
+    size_t data_offset;
+} FatImage;
+
+bool OpenFatImage(FatImage * image, const Source * source);
+bool CollectFatResources(ViewList * list,
+                         const FatImage * image,
+                         const char * path,
+                         ResourceType type);
+
+//
+// sci.c
+//
+
+bool ParseSCIView(View * view, const Uint8 * data, size_t size);
+int DecodeRowsSCI0(CelRows * rows, int count, Uint8 * out, int pitch);
+bool CollectSCIViews(ViewList * list,
+                     const char * prefix,
+                     GameFileFunc load,
+                     void * context);
+bool IsSCIViewPatch(const Uint8 * data, size_t size, size_t * offset);
+
+//
+// sheet.c
+//
+
+typedef struct {
+    int loop;
+    int cel;
+    int shrink;
+    int columns;
+    const char * output;    // .bmp or .png
+    int num_threads;        // For PNG compression.
+} SheetOptions;
+
+void GetViewLabel(const ViewResource * resource, char * label, size_t size);
+bool MakeContactSheet(const ViewList * list, const SheetOptions * options);
+
+//
+// viewer.c
+//
+
+typedef struct {
+    int frames;             // Run this many frames and report timings, or 0
+                            // to run until closed.
+    size_t cache_bytes;     // Memory allowed for decoded cel textures.
+} ViewerOptions;
+
+bool RunViewer(const ViewList * list, const ViewerOptions * options);
+
+//
+// pool.c
+//
+
+typedef void (* WorkFunc)(int index, void * context);
+
+int GetNumThreads(int requested);
+void RunParallel(int count, int num_threads, WorkFunc func, void * context);
+
+//
+// jobserver.c
+//
+
+bool JobserverInit(void);
+bool JobserverActive(void);
+bool JobserverAcquire(Uint8 * token, bool (* done)(void * context), void * context);
+void JobserverRelease(Uint8 token);
+
+//
+// diff.c
+//
+
+typedef struct {
+    bool images;            // Write a comparison image of each changed View.
+    const char * directory; // Where to write comparison images.
+    const char * extension; // Their image format, e.g. "png".
+    int num_threads;
+} DiffOptions;
+
+int DiffGames(const char * path_a, const char * path_b, const DiffOptions * options);
+
+//
+// delta.c
+//
+
+typedef void (* DeltaFrameFunc)(int loop,
+                                int cel,
+                                const Uint8 * canvas,
+                                int w,
+                                int h,
+                                int x_scale,
+                                void * context);
+
+Uint8 * EncodeDelta(const DecodedView * decoded, size_t * size);
+bool DecodeDelta(const Uint8 * data, size_t size, DeltaFrameFunc func, void * context);
+bool DeltaToBMP(const char * path);
+
+//
+// jobs.c
+//
+
+bool RunJobFile(const char * path, int num_threads, const char * metrics_path);
+
+//
+// bench.c
+//
+
+bool RunBenchmark(const ViewList * list, int repeat);
+
+//
+// profile.c
+//
+
+bool ProfileViews(const ViewList * list, const char * path);
+bool SynthesizeGame(const char * profile_path, const char * directory, int count, Uint64 seed);
+
+//
+// scan.c
+//
+
+typedef void (* ScanFunc)(const ViewResource * view, void * context);
+
+bool ScanVolume(const char * path, ScanFunc func, void * context);
+
+//
+// png.c
+//
+
+bool SavePNG(SDL_Surface * surface, const char * path, int num_threads);
+bool SaveImage(SDL_Surface * surface, const char * path, int num_threads);
+
+//
+// texture.c
+//
+
+bool SaveDDS(SDL_Surface * surface, const char * path);
+bool SaveKTX2(SDL_Surface * surface, const char * path);
+
+//
+// stats.c
+//
+
+bool EnableStats(void);
+void BeginViewStats(void);
+void CountSurface(const SDL_Surface * surface);
+void EndViewStats(const char * name);
+void PrintStats(void);
+
+//
+// progress.c
+//
+
+void StartProgress(int total_files, const char * metrics_path);
+bool ProgressActive(void);
+void CountProgress(size_t size, bool ok);
+void PrintError(const char * format, ...);
+void FinishProgress(void);
+
+//
+// deps.c
+//
+
+void InitDependencies(bool per_output, const char * path, bool update);
+void RecordDependencies(const char * output, const ViewResource * const * views, int count);
+bool IsUpToDate(const char * output, const ViewResource * const * views, int count);
+bool FinishDependencies(void);
+
+//
+// csource.c
+//
+
+bool ExportCSource(const ViewList * list, const char * base);
+
+//
+// pic.c
+//
+
+#define PIC_WIDTH 160
+#define PIC_HEIGHT 168
+
+typedef struct PicRow PicRow;
+
+/// A picture's visual and priority screens partway through drawing. Frames
+/// share the rows that did not change between them.
+typedef struct {
+    PicRow * rows[PIC_HEIGHT];
+    int num_commands;   // Commands drawn so far.
+} PicFrame;
+
+typedef struct {
+    PicFrame * frames;
+    int num_frames;
+    int rows_copied;    // Rows copied on write, across all frames.
+} PicDrawing;
+
+bool DrawPicture(PicDrawing * drawing, const Uint8 * data, size_t size, int interval);
+SDL_Surface * RenderPicFrame(const PicFrame * frame, bool priority);
+void FreePicDrawing(PicDrawing * drawing);
+
+#endif /* agi_h */
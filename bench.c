@@ -0,0 +1,198 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#include "agi.h"
+
+static const struct {
+    DecodeKernel kernel;
+    const char * name;
+} kernels[] = {
+    { KERNEL_SCALAR, "scalar" },
+    { KERNEL_PREFIX, "prefix" },
+    { KERNEL_AUTO, "auto" },
+};
+
+#define SLICE_ROWS 16
+
+
+
+/// Decode a View with a ViewDecoder, SLICE_ROWS at a time as an interactive
+/// tool would, timing each slice and checking the result against DecodeView.
+/// Returns the number of cels that differ.
+static int
+BenchSlices(const View * view, const char * name, Uint64 * time, Uint64 * longest, int * count)
+{
+    DecodedView expected;
+    ViewDecoder decoder;
+    if ( !DecodeView(&expected, view) ) {
+        return 0;
+    }
+
+    if ( !StartViewDecoder(&decoder, view) ) {
+        FreeDecodedView(&expected);
+        return 0;
+    }
+
+    while ( !decoder.done ) {
+        Uint64 start = SDL_GetTicksNS();
+        bool ok = ContinueViewDecoder(&decoder, SLICE_ROWS, 0);
+        Uint64 elapsed = SDL_GetTicksNS() - start;
+
+        if ( !ok ) {
+            break;
+        }
+
+        *time += elapsed;
+        *longest = SDL_max(*longest, elapsed);
+        (*count)++;
+    }
+
+    int mismatches = 0;
+    for ( int i = 0; i < view->num_loops && decoder.done; i++ ) {
+        for ( int j = 0; j < view->loops[i].num_cels; j++ ) {
+            const Cel * cel = &view->loops[i].cels[j];
+            if ( memcmp(GetDecodedCel(&expected, i, j),
+                        GetDecodedCel(&decoder.decoded, i, j),
+                        cel->width * cel->height) != 0 ) {
+                printf("Error: sliced decode differs on %s loop %d cel %d\n", name, i, j);
+                mismatches++;
+            }
+        }
+    }
+
+    FreeViewDecoder(&decoder);
+    FreeDecodedView(&expected);
+
+    return mismatches;
+}
+
+
+
+/// Time each decode kernel over every cel of every View in the list, checking
+/// that they all produce the same pixels. Each View is decoded `repeat` times
+/// per kernel, then once more in slices with a ViewDecoder. Returns false if
+/// the kernels' pixels differ.
+bool
+RunBenchmark(const ViewList * list, int repeat)
+{
+    const int num_kernels = SDL_arraysize(kernels);
+    Uint64 times[SDL_arraysize(kernels)] = { 0 };
+    Uint64 pixels = 0;
+    Uint64 bytes = 0;
+    int num_cels = 0;
+    int mismatches = 0;
+    Uint64 slice_time = 0;
+    Uint64 longest_slice = 0;
+    int num_slices = 0;
+
+    DecodeKernel saved_kernel = decode_kernel;
+    View * view = SDL_malloc(sizeof(*view));
+    Uint8 * expected = SDL_malloc(MAX_CEL_WIDTH * MAX_CEL_HEIGHT);
+    Uint8 * actual = SDL_malloc(MAX_CEL_WIDTH * MAX_CEL_HEIGHT);
+
+    repeat = SDL_max(repeat, 1);
+
+    for ( int v = 0; v < list->num_views; v++ ) {
+        const ViewResource * resource = &list->views[v];
+        if ( !ParseViewResource(view, resource) ) {
+            continue;
+        }
+
+        bytes += resource->size * (Uint64)repeat;
+
+        for ( int k = 0; k < num_kernels; k++ ) {
+            decode_kernel = kernels[k].kernel;
+            Uint64 start = SDL_GetTicksNS();
+
+            for ( int r = 0; r < repeat; r++ ) {
+                for ( int i = 0; i < view->num_loops; i++ ) {
+                    for ( int j = 0; j < view->loops[i].num_cels; j++ ) {
+                        DecodeCel(view, i, j, actual, view->loops[i].cels[j].width);
+                    }
+                }
+            }
+
+            times[k] += SDL_GetTicksNS() - start;
+        }
+
+        // Check every kernel's output against the scalar kernel.
+        for ( int i = 0; i < view->num_loops; i++ ) {
+            for ( int j = 0; j < view->loops[i].num_cels; j++ ) {
+                const Cel * cel = &view->loops[i].cels[j];
+                size_t size = cel->width * cel->height;
+
+                decode_kernel = KERNEL_SCALAR;
+                DecodeCel(view, i, j, expected, cel->width);
+
+                for ( int k = 1; k < num_kernels; k++ ) {
+                    decode_kernel = kernels[k].kernel;
+                    DecodeCel(view, i, j, actual, cel->width);
+                    if ( memcmp(expected, actual, size) != 0 ) {
+                        printf("Error: %s kernel differs on %s loop %d cel %d\n",
+                               kernels[k].name, resource->name, i, j);
+                        mismatches++;
+                    }
+                }
+
+                pixels += size * repeat;
+                num_cels++;
+            }
+        }
+
+        decode_kernel = saved_kernel;
+        mismatches += BenchSlices(view, resource->name, &slice_time, &longest_slice, &num_slices);
+        ReleaseView(view);
+    }
+
+    decode_kernel = saved_kernel;
+
+    printf("%d Views, %d cels, %d repeats\n", list->num_views, num_cels, repeat);
+    printf("%-8s %10s %12s %10s\n", "kernel", "time (ms)", "Mpixels/s", "MB/s in");
+    for ( int k = 0; k < num_kernels; k++ ) {
+        double seconds = times[k] / 1e9;
+        printf("%-8s %10.2f %12.1f %10.1f\n",
+               kernels[k].name,
+               seconds * 1000.0,
+               seconds > 0 ? pixels / seconds / 1e6 : 0.0,
+               seconds > 0 ? bytes / seconds / 1e6 : 0.0);
+    }
+
+    if ( num_slices > 0 ) {
+        printf("sliced: %d slices of %d rows, mean %.1f us, longest %.1f us\n",
+               num_slices,
+               SLICE_ROWS,
+               slice_time / 1e3 / num_slices,
+               longest_slice / 1e3);
+    }
+
+    if ( mismatches ) {
+        printf("%d mismatches\n", mismatches);
+    }
+
+    SDL_free(actual);
+    SDL_free(expected);
+    SDL_free(view);
+
+    return mismatches == 0;
+}
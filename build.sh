@@ -1,2 +1,2 @@
 #!/bin/bash
-cc main.c -lSDL3 -o agiview2bmp
+cc *.c -lSDL3 -o agiview2bmp
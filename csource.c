@@ -0,0 +1,488 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+// C source export, for ports that compile their sprites into the program.
+//
+// A header and source file pair is written with every View's cels packed into
+// one byte array, and index tables to find them, so nothing is loaded or
+// parsed at startup. Each cel is stored in whichever of two encodings is
+// smaller:
+//
+//  packed: rows of (width + 1) / 2 bytes, two pixels per byte, the left
+//          pixel in the high nibble. Transparent pixels hold the cel's
+//          transparency color.
+//  spans:  (cels up to 255 pixels wide) for each row, the number of spans,
+//          then for each span the number of transparent pixels skipped since
+//          the last one, its length, and (length + 1) / 2 bytes of its pixels,
+//          packed as above.
+//
+// Identical cels are stored once. A cel that is the mirror image of one
+// already stored refers to that one's data, and is flagged to be drawn
+// flipped.
+
+#include "agi.h"
+#include <ctype.h>
+#include <errno.h>
+
+#define CEL_MIRRORED 0x01
+#define CEL_SPANS 0x02
+
+
+
+typedef struct {
+    Uint8 * data;
+    size_t size;
+    size_t capacity;
+} Buffer;
+
+
+
+/// A cel in the index table.
+typedef struct {
+    Uint32 offset;
+    Uint16 width;
+    Uint16 height;
+    Uint8 transparency_color;
+    Uint8 flags;
+    Uint32 size;    // Bytes of data, for finding duplicates.
+} IndexCel;
+
+
+
+typedef struct {
+    Buffer data;
+    IndexCel * cels;
+    int num_cels;
+    Buffer scratch;     // A cel being encoded.
+} Export;
+
+
+
+static void
+Put(Buffer * buffer, Uint8 byte)
+{
+    if ( buffer->size == buffer->capacity ) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        buffer->data = SDL_realloc(buffer->data, buffer->capacity);
+    }
+
+    buffer->data[buffer->size++] = byte;
+}
+
+
+
+static void
+PutPixels(Buffer * buffer, const Uint8 * pixels, int count)
+{
+    for ( int i = 0; i < count; i += 2 ) {
+        Uint8 right = i + 1 < count ? pixels[i + 1] : 0;
+        Put(buffer, (pixels[i] << 4) | right);
+    }
+}
+
+
+
+/// Encode a cel's pixels, choosing the smaller encoding. Returns its flags.
+static Uint8
+EncodeCel(Buffer * out, const Uint8 * pixels, int w, int h, int transparency_color)
+{
+    out->size = 0;
+    size_t packed_size = (size_t)((w + 1) / 2) * h;
+
+    if ( w <= 255 ) {
+        for ( int y = 0; y < h; y++ ) {
+            const Uint8 * row = pixels + y * w;
+            size_t count_at = out->size;
+            int num_spans = 0;
+            int x = 0;
+
+            Put(out, 0); // Span count, filled in below.
+            while ( x < w ) {
+                int start = x;
+                while ( start < w && row[start] == transparency_color ) {
+                    start++;
+                }
+                if ( start == w ) {
+                    break;
+                }
+
+                int end = start;
+                while ( end < w && row[end] != transparency_color ) {
+                    end++;
+                }
+
+                Put(out, start - x);
+                Put(out, end - start);
+                PutPixels(out, row + start, end - start);
+                num_spans++;
+                x = end;
+            }
+            out->data[count_at] = num_spans;
+
+            if ( out->size >= packed_size ) {
+                break;
+            }
+        }
+
+        if ( out->size < packed_size ) {
+            return CEL_SPANS;
+        }
+    }
+
+    out->size = 0;
+    for ( int y = 0; y < h; y++ ) {
+        PutPixels(out, pixels + y * w, w);
+    }
+
+    return 0;
+}
+
+
+
+/// Find a stored cel drawn the same way as `cel` whose data matches the cel
+/// just encoded.
+static const IndexCel *
+FindCel(const Export * export, const IndexCel * cel)
+{
+    const Buffer * encoded = &export->scratch;
+
+    for ( int i = 0; i < export->num_cels; i++ ) {
+        const IndexCel * stored = &export->cels[i];
+        if ( stored->width == cel->width
+            && stored->height == cel->height
+            && stored->transparency_color == cel->transparency_color
+            && (stored->flags & CEL_SPANS) == (cel->flags & CEL_SPANS)
+            && stored->size == encoded->size
+            && (encoded->size == 0
+                || memcmp(export->data.data + stored->offset,
+                          encoded->data,
+                          encoded->size) == 0) ) {
+            return stored;
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/// Add a cel to the index, storing its data unless the same data or its
+/// mirror image is already stored.
+static void
+AddCel(Export * export, const Uint8 * pixels, int w, int h, int transparency_color)
+{
+    IndexCel cel = {
+        .width = w,
+        .height = h,
+        .transparency_color = transparency_color,
+    };
+
+    cel.flags = EncodeCel(&export->scratch, pixels, w, h, transparency_color);
+    const IndexCel * match = FindCel(export, &cel);
+
+    if ( match == NULL ) {
+        Uint8 * flipped = SDL_malloc((size_t)w * h);
+        for ( int y = 0; y < h; y++ ) {
+            for ( int x = 0; x < w; x++ ) {
+                flipped[y * w + x] = pixels[y * w + (w - 1 - x)];
+            }
+        }
+
+        cel.flags = EncodeCel(&export->scratch, flipped, w, h, transparency_color);
+        match = FindCel(export, &cel);
+        SDL_free(flipped);
+
+        if ( match ) {
+            cel.flags |= CEL_MIRRORED;
+        } else {
+            cel.flags = EncodeCel(&export->scratch, pixels, w, h, transparency_color);
+        }
+    }
+
+    if ( match ) {
+        cel.offset = match->offset;
+        cel.size = match->size;
+    } else {
+        cel.offset = (Uint32)export->data.size;
+        cel.size = (Uint32)export->scratch.size;
+        for ( size_t i = 0; i < export->scratch.size; i++ ) {
+            Put(&export->data, export->scratch.data[i]);
+        }
+    }
+
+    export->cels = SDL_realloc(export->cels, (export->num_cels + 1) * sizeof(IndexCel));
+    export->cels[export->num_cels++] = cel;
+}
+
+
+
+/// Make a C identifier from the file name of `path`.
+static void
+GetSymbolPrefix(const char * path, char * prefix, size_t size, bool upper)
+{
+    const char * name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    size_t n = 0;
+    if ( isdigit((unsigned char)name[0]) && n < size - 1 ) {
+        prefix[n++] = '_';
+    }
+
+    for ( ; *name && n < size - 1; name++ ) {
+        char c = isalnum((unsigned char)*name) ? *name : '_';
+        prefix[n++] = upper ? toupper(c) : tolower(c);
+    }
+    prefix[n] = '\0';
+}
+
+
+
+static bool
+WriteHeader(const char * path, const char * p, const char * P, const Export * export,
+            int num_views, int num_loops)
+{
+    FILE * file = fopen(path, "w");
+    if ( file == NULL ) {
+        printf("Error: could not create '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    fprintf(file,
+            "/* Generated by agiview2bmp. Do not edit. */\n"
+            "\n"
+            "#ifndef %s_H\n"
+            "#define %s_H\n"
+            "\n"
+            "#include <stdint.h>\n"
+            "\n"
+            "#define %s_NUM_VIEWS %d\n"
+            "#define %s_NUM_LOOPS %d\n"
+            "#define %s_NUM_CELS %d\n"
+            "#define %s_DATA_SIZE %zu\n"
+            "\n"
+            "/* Draw the cel flipped horizontally. */\n"
+            "#define %s_CEL_MIRRORED 0x%02X\n"
+            "\n"
+            "/* The cel is stored as spans rather than packed. Packed: rows of\n"
+            "   (width + 1) / 2 bytes, two pixels per byte, the left pixel in the\n"
+            "   high nibble. Spans: for each row, the number of spans, then for\n"
+            "   each span the number of transparent pixels since the last one,\n"
+            "   its length, and (length + 1) / 2 bytes of its pixels, packed. */\n"
+            "#define %s_CEL_SPANS 0x%02X\n"
+            "\n"
+            "typedef struct {\n"
+            "    uint32_t offset;   /* Of the cel's data in %s_data. */\n"
+            "    uint16_t width;\n"
+            "    uint16_t height;\n"
+            "    uint8_t transparency_color;\n"
+            "    uint8_t flags;\n"
+            "} %s_cel;\n"
+            "\n"
+            "typedef struct {\n"
+            "    uint32_t first_cel; /* Index in %s_cels. */\n"
+            "    uint8_t num_cels;\n"
+            "} %s_loop;\n"
+            "\n"
+            "typedef struct {\n"
+            "    uint32_t first_loop; /* Index in %s_loops. */\n"
+            "    int16_t number;      /* View number in its game, or -1. */\n"
+            "    uint8_t num_loops;\n"
+            "    uint8_t pixel_width; /* Displayed width of a pixel. */\n"
+            "} %s_view;\n"
+            "\n"
+            "extern const %s_view %s_views[%s_NUM_VIEWS];\n"
+            "extern const %s_loop %s_loops[%s_NUM_LOOPS];\n"
+            "extern const %s_cel %s_cels[%s_NUM_CELS];\n"
+            "extern const uint8_t %s_data[%s_DATA_SIZE];\n"
+            "extern const uint8_t %s_palette[16][3];\n"
+            "\n"
+            "#endif\n",
+            P, P,
+            P, num_views, P, num_loops, P, export->num_cels, P, export->data.size,
+            P, CEL_MIRRORED, P, CEL_SPANS,
+            p, p, p, p, p, p,
+            p, p, P, p, p, P, p, p, P, p, P, p);
+
+    bool ok = ferror(file) == 0;
+    ok &= fclose(file) == 0;
+
+    return ok;
+}
+
+
+
+/// Write every View in `list` as C source: `base`.h and `base`.c, with
+/// symbols named after the file name of `base`.
+bool
+ExportCSource(const ViewList * list, const char * base)
+{
+    char header_path[MAX_PATH_LENGTH];
+    char source_path[MAX_PATH_LENGTH];
+    snprintf(header_path, sizeof(header_path), "%s.h", base);
+    snprintf(source_path, sizeof(source_path), "%s.c", base);
+
+    const ViewResource ** resources = SDL_calloc(list->num_views, sizeof(*resources));
+    for ( int i = 0; i < list->num_views; i++ ) {
+        resources[i] = &list->views[i];
+    }
+
+    if ( IsUpToDate(header_path, resources, list->num_views)
+        && IsUpToDate(source_path, resources, list->num_views) ) {
+        printf("%s is up to date\n", source_path);
+        RecordDependencies(header_path, resources, list->num_views);
+        RecordDependencies(source_path, resources, list->num_views);
+        SDL_free(resources);
+        return true;
+    }
+
+    char p[128], P[128];
+    GetSymbolPrefix(base, p, sizeof(p), false);
+    GetSymbolPrefix(base, P, sizeof(P), true);
+
+    Export export = { 0 };
+    Buffer views = { 0 }; // Source text of the view and loop tables.
+    Buffer loops = { 0 };
+    int num_views = 0;
+    int num_loops = 0;
+
+    View * view = SDL_malloc(sizeof(*view));
+    for ( int i = 0; i < list->num_views; i++ ) {
+        const ViewResource * resource = &list->views[i];
+        DecodedView decoded;
+        if ( !ParseViewResource(view, resource) ) {
+            printf("Exporting %s... Error: not a valid View\n", resource->name);
+            continue;
+        }
+        if ( !DecodeView(&decoded, view) ) {
+            printf("Exporting %s... Error: %s\n", resource->name, SDL_GetError());
+            ReleaseView(view);
+            continue;
+        }
+
+        char line[MAX_PATH_LENGTH + 64];
+        snprintf(line, sizeof(line), "    { %d, %d, %d, %d }, /* %d: %s */\n",
+                 num_loops, resource->number, view->num_loops, view->pixel_width,
+                 num_views, resource->name);
+        for ( const char * c = line; *c; c++ ) {
+            Put(&views, *c);
+        }
+
+        for ( int l = 0; l < view->num_loops; l++ ) {
+            const Loop * loop = &view->loops[l];
+            snprintf(line, sizeof(line), "    { %d, %d },\n", export.num_cels, loop->num_cels);
+            for ( const char * c = line; *c; c++ ) {
+                Put(&loops, *c);
+            }
+
+            for ( int c = 0; c < loop->num_cels; c++ ) {
+                const Cel * cel = &loop->cels[c];
+                AddCel(&export,
+                       GetDecodedCel(&decoded, l, c),
+                       cel->width,
+                       cel->height,
+                       cel->transparency_color);
+            }
+        }
+
+        num_views++;
+        num_loops += view->num_loops;
+        FreeDecodedView(&decoded);
+        ReleaseView(view);
+    }
+    SDL_free(view);
+    Put(&views, '\0');
+    Put(&loops, '\0');
+
+    // C has no empty arrays.
+    bool ok = num_views > 0 && export.num_cels > 0;
+    if ( !ok ) {
+        printf("Error: no cels to export\n");
+    } else if ( export.data.size == 0 ) {
+        Put(&export.data, 0);
+    }
+
+    ok = ok && WriteHeader(header_path, p, P, &export, num_views, num_loops);
+
+    FILE * file = ok ? fopen(source_path, "w") : NULL;
+    if ( ok && file == NULL ) {
+        printf("Error: could not create '%s': %s\n", source_path, strerror(errno));
+        ok = false;
+    }
+
+    if ( file ) {
+        const char * header_name = strrchr(header_path, '/');
+        header_name = header_name ? header_name + 1 : header_path;
+
+        fprintf(file, "/* Generated by agiview2bmp. Do not edit. */\n\n");
+        fprintf(file, "#include \"%s\"\n\n", header_name);
+
+        fprintf(file, "const %s_view %s_views[%s_NUM_VIEWS] = {\n%s};\n\n",
+                p, p, P, views.data);
+        fprintf(file, "const %s_loop %s_loops[%s_NUM_LOOPS] = {\n%s};\n\n",
+                p, p, P, loops.data);
+
+        fprintf(file, "const %s_cel %s_cels[%s_NUM_CELS] = {\n", p, p, P);
+        for ( int i = 0; i < export.num_cels; i++ ) {
+            const IndexCel * cel = &export.cels[i];
+            fprintf(file, "    { %u, %u, %u, %u, 0x%02X },\n",
+                    cel->offset, cel->width, cel->height,
+                    cel->transparency_color, cel->flags);
+        }
+        fprintf(file, "};\n\n");
+
+        fprintf(file, "const uint8_t %s_data[%s_DATA_SIZE] = {", p, P);
+        for ( size_t i = 0; i < export.data.size; i++ ) {
+            fprintf(file, "%s0x%02X,", i % 16 == 0 ? "\n    " : " ", export.data.data[i]);
+        }
+        fprintf(file, "\n};\n\n");
+
+        fprintf(file, "const uint8_t %s_palette[16][3] = {\n", p);
+        for ( int i = 0; i < 16; i++ ) {
+            fprintf(file, "    { 0x%02X, 0x%02X, 0x%02X },\n", pal[i].r, pal[i].g, pal[i].b);
+        }
+        fprintf(file, "};\n");
+
+        ok = ferror(file) == 0;
+        ok &= fclose(file) == 0;
+        if ( !ok ) {
+            printf("Error: could not write '%s'\n", source_path);
+        }
+    }
+
+    if ( ok ) {
+        printf("saved %s and %s: %d Views, %d cels, %zu bytes of cel data\n",
+               header_path, source_path, num_views, export.num_cels, export.data.size);
+        RecordDependencies(header_path, resources, list->num_views);
+        RecordDependencies(source_path, resources, list->num_views);
+    }
+
+    SDL_free(export.data.data);
+    SDL_free(export.scratch.data);
+    SDL_free(export.cels);
+    SDL_free(views.data);
+    SDL_free(loops.data);
+    SDL_free(resources);
+
+    return ok;
+}
@@ -0,0 +1,150 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+// Resumable decoding, for interactive tools that can't afford to stall while
+// a large View decodes. A ViewDecoder decodes a View's cels in order, loop by
+// loop, a row at a time, stopping once a budget of rows or time is spent and
+// carrying on from there on the next call. An editor can decode a little each
+// frame, drawing the rows that are done so far, with a bounded cost per frame.
+
+#include "agi.h"
+
+// With a time budget, the clock is checked after this many rows. A row is at
+// most a few hundred pixels, so a budget is overrun by a few microseconds at
+// most.
+#define ROWS_PER_CHECK 8
+
+
+
+/// Move on to the next cel with any rows, or finish if there are none left.
+static void
+NextCel(ViewDecoder * decoder)
+{
+    const View * view = decoder->decoded.view;
+
+    while ( decoder->loop_num < view->num_loops ) {
+        const Loop * loop = &view->loops[decoder->loop_num];
+        if ( decoder->cel_num < loop->num_cels ) {
+            StartCelRows(&decoder->rows, view, decoder->loop_num, decoder->cel_num);
+            return;
+        }
+
+        decoder->loop_num++;
+        decoder->cel_num = 0;
+    }
+
+    decoder->done = true;
+}
+
+
+
+/// Start decoding a View, which must stay parsed until the decoder is freed.
+/// The cels' pixels are undefined until decoded; see GetDecodedRows.
+bool
+StartViewDecoder(ViewDecoder * decoder, const View * view)
+{
+    SDL_zerop(decoder);
+    if ( !AllocateDecodedView(&decoder->decoded, view) ) {
+        return false;
+    }
+
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        for ( int j = 0; j < view->loops[i].num_cels; j++ ) {
+            decoder->total_rows += view->loops[i].cels[j].height;
+        }
+    }
+
+    NextCel(decoder);
+
+    return true;
+}
+
+
+
+/// Decode until `max_rows` more rows are done or `max_ns` nanoseconds have
+/// passed, either of which may be 0 for no limit, or until the View is done.
+/// Fails, with the reason set as the SDL error, if a cel is malformed in
+/// bounded mode, after which the decoder can only be freed.
+bool
+ContinueViewDecoder(ViewDecoder * decoder, int max_rows, Uint64 max_ns)
+{
+    Uint64 deadline = max_ns ? SDL_GetTicksNS() + max_ns : 0;
+    int budget = max_rows > 0 ? max_rows : SDL_MAX_SINT32;
+
+    while ( !decoder->done && budget > 0 ) {
+        const Cel * cel = decoder->rows.cel;
+        Uint8 * out = GetDecodedCel(&decoder->decoded, decoder->loop_num, decoder->cel_num);
+        int count = deadline ? SDL_min(budget, ROWS_PER_CHECK) : budget;
+
+        int n = DecodeCelRows(&decoder->rows, count, out, cel->width);
+        decoder->rows_done += n;
+        budget -= n;
+
+        if ( decoder->rows.y == cel->height ) {
+            if ( !decoder->rows.ok && decode_bounded ) {
+                return SDL_SetError("loop %d cel %d: truncated or malformed data",
+                                    decoder->loop_num,
+                                    decoder->cel_num);
+            }
+
+            decoder->cel_num++;
+            NextCel(decoder);
+        }
+
+        if ( deadline && SDL_GetTicksNS() >= deadline ) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+
+/// The number of rows of a cel that have been decoded so far.
+int
+GetDecodedRows(const ViewDecoder * decoder, int loop_num, int cel_num)
+{
+    const Cel * cel = &decoder->decoded.view->loops[loop_num].cels[cel_num];
+
+    if ( decoder->done || loop_num < decoder->loop_num
+        || (loop_num == decoder->loop_num && cel_num < decoder->cel_num) ) {
+        return cel->height;
+    }
+
+    if ( loop_num == decoder->loop_num && cel_num == decoder->cel_num ) {
+        return decoder->rows.y;
+    }
+
+    return 0;
+}
+
+
+
+void
+FreeViewDecoder(ViewDecoder * decoder)
+{
+    FreeDecodedView(&decoder->decoded);
+    SDL_zerop(decoder);
+}
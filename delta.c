@@ -0,0 +1,463 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Delta-encoded loop animations (.agd)
+//
+// Each loop is stored as a keyframe followed by the changes from one cel to
+// the next, so a player only has to stream and apply what moves. Cels are
+// placed on a canvas the size of the loop's largest cel, aligned to the
+// bottom-left corner as AGI positions them.
+//
+// All numbers are little-endian.
+//
+//  file:   'A' 'G' 'D' version(1) x_scale(1) num_loops(1) loop...
+//  loop:   num_cels(1) width(2) height(2) cel...
+//  cel:    0 runs         keyframe: runs cover the whole canvas
+//          1 x(2) y(2) w(2) h(2) runs
+//                         delta: runs cover the rectangle, all other pixels
+//                         are unchanged from the previous cel
+//  runs:   in row-major order, until the area is covered:
+//          cccc nnnn          n (1-15) pixels of color c
+//          0x00 count(1)      count transparent pixels
+//          0x10 count(1)      count pixels left as they were in the
+//                             previous cel
+//
+
+#include "agi.h"
+#include <errno.h>
+
+#define DELTA_VERSION 1
+#define DELTA_CLEAR 16
+#define DELTA_KEEP 17
+
+#define MAX_CANVAS (MAX_CEL_WIDTH * MAX_CEL_HEIGHT)
+
+
+
+typedef struct {
+    Uint8 * data;
+    size_t size;
+    size_t capacity;
+} Buffer;
+
+
+
+static void
+Put(Buffer * buffer, Uint8 byte)
+{
+    if ( buffer->size == buffer->capacity ) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        buffer->data = SDL_realloc(buffer->data, buffer->capacity);
+    }
+
+    buffer->data[buffer->size++] = byte;
+}
+
+
+
+static void
+Put16(Buffer * buffer, Uint16 value)
+{
+    Put(buffer, value & 0xFF);
+    Put(buffer, value >> 8);
+}
+
+
+
+/// Draw a cel onto a loop canvas, aligned to the bottom-left corner, with
+/// transparent pixels set to DELTA_CLEAR.
+static void
+DrawCanvas(const DecodedView * decoded,
+           int loop_num,
+           int cel_num,
+           Uint8 * canvas,
+           int w,
+           int h)
+{
+    const Cel * cel = &decoded->view->loops[loop_num].cels[cel_num];
+    const Uint8 * pixels = GetDecodedCel(decoded, loop_num, cel_num);
+
+    memset(canvas, DELTA_CLEAR, w * h);
+    int top = h - cel->height;
+
+    for ( int y = 0; y < cel->height; y++ ) {
+        for ( int x = 0; x < cel->width; x++ ) {
+            Uint8 color = pixels[y * cel->width + x];
+            if ( color != cel->transparency_color ) {
+                canvas[(top + y) * w + x] = color;
+            }
+        }
+    }
+}
+
+
+
+static void
+PutRun(Buffer * buffer, int value, int count)
+{
+    if ( count == 0 ) {
+        return;
+    }
+
+    if ( value < DELTA_CLEAR ) {
+        Put(buffer, (value << 4) | count);
+    } else {
+        Put(buffer, value == DELTA_CLEAR ? 0x00 : 0x10);
+        Put(buffer, count);
+    }
+}
+
+
+
+/// Run-encode a rectangle of `canvas`. Pixels equal to the same pixel in
+/// `previous` (if given) are encoded as DELTA_KEEP.
+static void
+PutRuns(Buffer * buffer,
+        const Uint8 * canvas,
+        const Uint8 * previous,
+        int pitch,
+        SDL_Rect rect)
+{
+    int value = -1;
+    int count = 0;
+
+    for ( int y = rect.y; y < rect.y + rect.h; y++ ) {
+        for ( int x = rect.x; x < rect.x + rect.w; x++ ) {
+            int i = y * pitch + x;
+            int v = previous && previous[i] == canvas[i] ? DELTA_KEEP : canvas[i];
+
+            int max_count = v < DELTA_CLEAR ? 15 : 255;
+
+            if ( v != value || count == max_count ) {
+                PutRun(buffer, value, count);
+                value = v;
+                count = 0;
+            }
+            count++;
+        }
+    }
+
+    PutRun(buffer, value, count);
+}
+
+
+
+/// Find the bounding rectangle of the pixels that differ between two canvases.
+static SDL_Rect
+GetDirtyRect(const Uint8 * canvas, const Uint8 * previous, int w, int h)
+{
+    int x0 = w, y0 = h, x1 = 0, y1 = 0;
+
+    for ( int y = 0; y < h; y++ ) {
+        for ( int x = 0; x < w; x++ ) {
+            if ( canvas[y * w + x] != previous[y * w + x] ) {
+                x0 = SDL_min(x0, x);
+                y0 = SDL_min(y0, y);
+                x1 = SDL_max(x1, x + 1);
+                y1 = SDL_max(y1, y + 1);
+            }
+        }
+    }
+
+    if ( x1 == 0 ) {
+        return (SDL_Rect){ 0, 0, 0, 0 };
+    }
+
+    return (SDL_Rect){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+
+
+/// Encode every loop of a View. Returns a buffer to be freed with SDL_free.
+Uint8 *
+EncodeDelta(const DecodedView * decoded, size_t * size)
+{
+    const View * view = decoded->view;
+    Buffer buffer = { 0 };
+    Uint8 * canvas = SDL_malloc(MAX_CANVAS);
+    Uint8 * previous = SDL_malloc(MAX_CANVAS);
+
+    Put(&buffer, 'A');
+    Put(&buffer, 'G');
+    Put(&buffer, 'D');
+    Put(&buffer, DELTA_VERSION);
+    Put(&buffer, view->pixel_width); // AGI pixels are double-wide.
+    Put(&buffer, view->num_loops);
+
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        const Loop * loop = &view->loops[i];
+        int w = 0;
+        int h = 0;
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            w = SDL_max(w, loop->cels[j].width);
+            h = SDL_max(h, loop->cels[j].height);
+        }
+
+        Put(&buffer, loop->num_cels);
+        Put16(&buffer, w);
+        Put16(&buffer, h);
+
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            DrawCanvas(decoded, i, j, canvas, w, h);
+
+            if ( j == 0 ) {
+                Put(&buffer, 0);
+                PutRuns(&buffer, canvas, NULL, w, (SDL_Rect){ 0, 0, w, h });
+            } else {
+                SDL_Rect dirty = GetDirtyRect(canvas, previous, w, h);
+                Put(&buffer, 1);
+                Put16(&buffer, dirty.x);
+                Put16(&buffer, dirty.y);
+                Put16(&buffer, dirty.w);
+                Put16(&buffer, dirty.h);
+                PutRuns(&buffer, canvas, previous, w, dirty);
+            }
+
+            memcpy(previous, canvas, w * h);
+        }
+    }
+
+    SDL_free(canvas);
+    SDL_free(previous);
+
+    *size = buffer.size;
+    return buffer.data;
+}
+
+
+
+typedef struct {
+    const Uint8 * data;
+    size_t size;
+    size_t pos;
+    bool error;
+} Reader;
+
+
+
+static Uint8
+Get(Reader * reader)
+{
+    if ( reader->pos >= reader->size ) {
+        reader->error = true;
+        return 0;
+    }
+
+    return reader->data[reader->pos++];
+}
+
+
+
+static Uint16
+Get16(Reader * reader)
+{
+    Uint8 lo = Get(reader);
+    return lo | (Get(reader) << 8);
+}
+
+
+
+/// Apply runs to a rectangle of the canvas.
+static void
+GetRuns(Reader * reader, Uint8 * canvas, int pitch, SDL_Rect rect)
+{
+    int total = rect.w * rect.h;
+    int i = 0;
+
+    while ( i < total && !reader->error ) {
+        Uint8 byte = Get(reader);
+        Uint8 value = byte >> 4;
+        int count = byte & 0x0F;
+
+        if ( count == 0 ) {
+            value = value == 0 ? DELTA_CLEAR : DELTA_KEEP;
+            count = Get(reader);
+        }
+        count = SDL_min(count, total - i);
+
+        for ( ; count > 0; count--, i++ ) {
+            if ( value != DELTA_KEEP ) {
+                canvas[(rect.y + i / rect.w) * pitch + rect.x + i % rect.w] = value;
+            }
+        }
+    }
+}
+
+
+
+/// Reference decoder: reconstruct every cel of a .agd file in order, calling
+/// `func` with the loop's canvas after each one. Canvas pixels are color
+/// indices, or DELTA_CLEAR where transparent.
+bool
+DecodeDelta(const Uint8 * data, size_t size, DeltaFrameFunc func, void * context)
+{
+    Reader reader = { .data = data, .size = size };
+
+    if ( Get(&reader) != 'A' || Get(&reader) != 'G' || Get(&reader) != 'D'
+        || Get(&reader) != DELTA_VERSION ) {
+        return false;
+    }
+
+    int x_scale = Get(&reader);
+    int num_loops = Get(&reader);
+    Uint8 * canvas = SDL_malloc(MAX_CANVAS);
+
+    for ( int i = 0; i < num_loops && !reader.error; i++ ) {
+        int num_cels = Get(&reader);
+        int w = Get16(&reader);
+        int h = Get16(&reader);
+        if ( (size_t)w * h > MAX_CANVAS ) {
+            reader.error = true;
+            break;
+        }
+
+        memset(canvas, DELTA_CLEAR, w * h);
+
+        for ( int j = 0; j < num_cels && !reader.error; j++ ) {
+            SDL_Rect rect = { 0, 0, w, h };
+
+            if ( Get(&reader) == 1 ) {
+                rect.x = Get16(&reader);
+                rect.y = Get16(&reader);
+                rect.w = Get16(&reader);
+                rect.h = Get16(&reader);
+                if ( rect.x + rect.w > w || rect.y + rect.h > h ) {
+                    reader.error = true;
+                    break;
+                }
+            }
+
+            GetRuns(&reader, canvas, w, rect);
+            func(i, j, canvas, w, h, x_scale, context);
+        }
+    }
+
+    SDL_free(canvas);
+
+    return !reader.error;
+}
+
+
+
+typedef struct {
+    SDL_Surface * surface;
+    int cel_x;
+    int cel_y;
+    int loop;
+    int loop_height;
+} Sheet;
+
+
+
+static void
+MeasureFrame(int loop, int cel, const Uint8 * canvas, int w, int h, int x_scale, void * context)
+{
+    (void)loop;
+    (void)canvas;
+    SDL_Rect * size = context;
+    if ( cel == 0 ) {
+        size->h += h;
+        size->x = 0; // Width of the current loop.
+    }
+
+    size->x += w * x_scale;
+    size->w = SDL_max(size->w, size->x);
+}
+
+
+
+static void
+DrawFrame(int loop, int cel, const Uint8 * canvas, int w, int h, int x_scale, void * context)
+{
+    (void)cel;
+    Sheet * sheet = context;
+    if ( loop != sheet->loop ) {
+        sheet->cel_y += sheet->loop_height;
+        sheet->cel_x = 0;
+        sheet->loop = loop;
+    }
+
+    sheet->loop_height = h;
+    BlitCel(sheet->surface,
+            sheet->cel_x,
+            sheet->cel_y,
+            canvas,
+            w,
+            h,
+            w,
+            DELTA_CLEAR,
+            NULL,
+            x_scale,
+            1);
+    sheet->cel_x += w * x_scale;
+}
+
+
+
+/// Decode a .agd file and save its frames as a bitmap, one loop per row.
+bool
+DeltaToBMP(const char * path)
+{
+    Source file;
+    if ( !OpenSource(&file, path) ) {
+        printf("Error: could not open '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    const Uint8 * data = file.data;
+    size_t size = file.size;
+
+    SDL_Rect size_rect = { 0 };
+    bool ok = DecodeDelta(data, size, MeasureFrame, &size_rect);
+    SDL_Surface * s = NULL;
+    if ( ok ) {
+        s = SDL_CreateSurface(size_rect.w, size_rect.h, SDL_PIXELFORMAT_RGBA32);
+    }
+
+    if ( s ) {
+        const SDL_PixelFormatDetails * details = SDL_GetPixelFormatDetails(s->format);
+        SDL_FillSurfaceRect(s, NULL, SDL_MapRGBA(details, NULL, 0, 0, 0, 0));
+
+        Sheet sheet = { .surface = s };
+        DecodeDelta(data, size, DrawFrame, &sheet);
+
+        char name[512];
+        snprintf(name, sizeof(name), "%s.bmp", path);
+        ok = SDL_SaveBMP(s, name);
+        if ( ok ) {
+            printf("saved %s\n", name);
+        } else {
+            printf("Error: could not save '%s': %s\n", name, SDL_GetError());
+        }
+        SDL_DestroySurface(s);
+    } else {
+        printf("Error: '%s' is not a valid .agd file\n", path);
+        ok = false;
+    }
+
+    CloseSource(&file);
+
+    return ok;
+}
@@ -0,0 +1,205 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Dependency files for incremental builds. Each output's rule lists exactly
+// the files its Views were read from: the View file, VIEWDIR and the one VOL
+// file holding the View, or the disk image. Rules use Make syntax, which
+// Ninja also reads (deps = gcc).
+//
+
+#include "agi.h"
+
+static struct {
+    bool per_output;        // Write "<output>.d" next to each output.
+    const char * path;      // Write every rule to this one file.
+    bool update;            // Skip outputs newer than all their inputs.
+    SDL_Mutex * lock;
+    char * rules;           // Rules collected for `path`.
+    size_t length;
+} deps;
+
+
+
+void
+InitDependencies(bool per_output, const char * path, bool update)
+{
+    deps.per_output = per_output;
+    deps.path = path;
+    deps.update = update;
+
+    if ( path ) {
+        deps.lock = SDL_CreateMutex();
+    }
+}
+
+
+
+/// Append `s` to a buffer, escaped for Make if `escape` is set: spaces and
+/// '#' are backslashed and '$' is doubled.
+static void
+Append(char ** buffer, size_t * length, const char * s, bool escape)
+{
+    *buffer = SDL_realloc(*buffer, *length + strlen(s) * 2 + 1);
+    char * p = *buffer + *length;
+
+    for ( ; *s; s++ ) {
+        if ( !escape ) {
+            // Copied as is.
+        } else if ( *s == ' ' || *s == '#' ) {
+            *p++ = '\\';
+        } else if ( *s == '$' ) {
+            *p++ = '$';
+        }
+        *p++ = *s;
+    }
+
+    *p = '\0';
+    *length = p - *buffer;
+}
+
+
+
+/// Make the rule "output: inputs" for the inputs of one or more Views, each
+/// listed once. Views with no input files, e.g. read from stdin, add none.
+static char *
+MakeRule(const char * output, const ViewResource * const * views, int count, size_t * length)
+{
+    char * rule = NULL;
+    *length = 0;
+
+    Append(&rule, length, output, true);
+    Append(&rule, length, ":", false);
+
+    for ( int i = 0; i < count; i++ ) {
+        for ( int j = 0; j < views[i]->num_inputs; j++ ) {
+            const char * input = views[i]->inputs[j];
+
+            // Skip inputs already listed by an earlier View.
+            bool listed = false;
+            for ( int k = 0; k < i && !listed; k++ ) {
+                for ( int l = 0; l < views[k]->num_inputs; l++ ) {
+                    listed |= strcmp(views[k]->inputs[l], input) == 0;
+                }
+            }
+            for ( int l = 0; l < j; l++ ) {
+                listed |= strcmp(views[i]->inputs[l], input) == 0;
+            }
+
+            if ( !listed ) {
+                Append(&rule, length, " \\\n ", false);
+                Append(&rule, length, input, true);
+            }
+        }
+    }
+
+    Append(&rule, length, "\n", false);
+
+    return rule;
+}
+
+
+
+/// Record that `output` was made from `views`.
+void
+RecordDependencies(const char * output, const ViewResource * const * views, int count)
+{
+    if ( !deps.per_output && deps.path == NULL ) {
+        return;
+    }
+
+    size_t length;
+    char * rule = MakeRule(output, views, count, &length);
+
+    if ( deps.per_output ) {
+        char path[MAX_PATH_LENGTH + 2];
+        snprintf(path, sizeof(path), "%s.d", output);
+        if ( !SDL_SaveFile(path, rule, length) ) {
+            printf("Error: could not save '%s': %s\n", path, SDL_GetError());
+        }
+    }
+
+    if ( deps.path ) {
+        SDL_LockMutex(deps.lock);
+        deps.rules = SDL_realloc(deps.rules, deps.length + length + 1);
+        memcpy(deps.rules + deps.length, rule, length + 1);
+        deps.length += length;
+        SDL_UnlockMutex(deps.lock);
+    }
+
+    SDL_free(rule);
+}
+
+
+
+/// With -update, check whether `output` exists and is at least as new as
+/// every input of `views`, in which case it needn't be made again. A View
+/// with no recorded inputs, e.g. one read from stdin, is always out of date.
+bool
+IsUpToDate(const char * output, const ViewResource * const * views, int count)
+{
+    SDL_PathInfo info;
+    if ( !deps.update || !SDL_GetPathInfo(output, &info) ) {
+        return false;
+    }
+
+    for ( int i = 0; i < count; i++ ) {
+        if ( views[i]->num_inputs == 0 ) {
+            return false;
+        }
+
+        for ( int j = 0; j < views[i]->num_inputs; j++ ) {
+            SDL_PathInfo input;
+            if ( !SDL_GetPathInfo(views[i]->inputs[j], &input)
+                || input.modify_time > info.modify_time ) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Write the collected rules, if an aggregate dependency file was requested.
+bool
+FinishDependencies(void)
+{
+    bool ok = true;
+
+    if ( deps.path ) {
+        ok = SDL_SaveFile(deps.path, deps.rules ? deps.rules : "", deps.length);
+        if ( !ok ) {
+            printf("Error: could not save '%s': %s\n", deps.path, SDL_GetError());
+        }
+
+        SDL_free(deps.rules);
+        SDL_DestroyMutex(deps.lock);
+    }
+
+    SDL_zero(deps);
+
+    return ok;
+}
@@ -0,0 +1,383 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#include "agi.h"
+#include <stdarg.h>
+
+// A pixel that is transparent in its cel, whatever the cel's transparency
+// color is.
+#define CLEAR 0x10
+
+
+
+typedef enum {
+    DIFF_SAME,
+    DIFF_CHANGED,
+    DIFF_ONLY_A,
+    DIFF_ONLY_B,
+} DiffStatus;
+
+
+
+typedef struct {
+    const ViewResource * a;
+    const ViewResource * b;
+    DiffStatus status;
+    char * report;
+    size_t report_length;
+} ViewDiff;
+
+
+
+typedef struct {
+    ViewDiff * diffs;
+    const DiffOptions * options;
+} DiffJob;
+
+
+
+static void
+Report(ViewDiff * diff, const char * format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    length = SDL_min(length, (int)sizeof(line) - 1);
+    diff->report = SDL_realloc(diff->report, diff->report_length + length + 1);
+    memcpy(diff->report + diff->report_length, line, length + 1);
+    diff->report_length += length;
+}
+
+
+
+/// 64-bit FNV-1a.
+static Uint64
+HashBytes(const Uint8 * data, size_t size)
+{
+    Uint64 hash = 0xCBF29CE484222325ull;
+    for ( size_t i = 0; i < size; i++ ) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+
+
+/// Decode a cel with transparent pixels replaced by CLEAR, so that cels with
+/// different transparency colors compare by what is actually drawn.
+static void
+DecodeForDiff(const View * view, int loop_num, int cel_num, Uint8 * out)
+{
+    const Cel * cel = &view->loops[loop_num].cels[cel_num];
+    DecodeCel(view, loop_num, cel_num, out, cel->width);
+
+    for ( int i = 0; i < cel->width * cel->height; i++ ) {
+        if ( out[i] == cel->transparency_color ) {
+            out[i] = CLEAR;
+        }
+    }
+}
+
+
+
+static void
+DiffCels(ViewDiff * diff,
+         const View * a,
+         const View * b,
+         int loop_num,
+         int cel_num,
+         Uint8 * pixels_a,
+         Uint8 * pixels_b)
+{
+    const Cel * cel_a = &a->loops[loop_num].cels[cel_num];
+    const Cel * cel_b = &b->loops[loop_num].cels[cel_num];
+
+    if ( cel_a->width != cel_b->width || cel_a->height != cel_b->height ) {
+        Report(diff, "  loop %d cel %d: size %dx%d -> %dx%d\n",
+               loop_num, cel_num,
+               cel_a->width, cel_a->height, cel_b->width, cel_b->height);
+        return;
+    }
+
+    DecodeForDiff(a, loop_num, cel_num, pixels_a);
+    DecodeForDiff(b, loop_num, cel_num, pixels_b);
+
+    int count = 0;
+    for ( int i = 0; i < cel_a->width * cel_a->height; i++ ) {
+        count += pixels_a[i] != pixels_b[i];
+    }
+
+    if ( count ) {
+        Report(diff, "  loop %d cel %d: %d of %d pixels differ\n",
+               loop_num, cel_num, count, cel_a->width * cel_a->height);
+    } else if ( CelIsMirrored(a, loop_num, cel_a) != CelIsMirrored(b, loop_num, cel_b) ) {
+        Report(diff, "  loop %d cel %d: mirroring changed\n", loop_num, cel_num);
+    }
+}
+
+
+
+/// Write an image with View A on the left, View B in the middle, and on the
+/// right, B with every pixel that differs from A highlighted in red.
+static void
+SaveDiffImage(ViewDiff * diff, View * a, View * b, const DiffOptions * options)
+{
+    SDL_Surface * sa = RenderView(a);
+    SDL_Surface * sb = RenderView(b);
+    if ( sa == NULL || sb == NULL ) {
+        Report(diff, "  Error: %s\n", SDL_GetError());
+        SDL_DestroySurface(sa);
+        SDL_DestroySurface(sb);
+        return;
+    }
+
+    int w = SDL_max(sa->w, sb->w);
+    int h = SDL_max(sa->h, sb->h);
+
+    SDL_Surface * s = SDL_CreateSurface(w * 3, h, SDL_PIXELFORMAT_RGBA32);
+    if ( s == NULL ) {
+        Report(diff, "  Error: %s\n", SDL_GetError());
+        SDL_DestroySurface(sa);
+        SDL_DestroySurface(sb);
+        return;
+    }
+
+    const SDL_PixelFormatDetails * details = SDL_GetPixelFormatDetails(s->format);
+    Uint32 highlight = SDL_MapRGBA(details, NULL, 0xFF, 0x00, 0x00, 0xFF);
+    SDL_FillSurfaceRect(s, NULL, SDL_MapRGBA(details, NULL, 0, 0, 0, 0));
+
+    for ( int y = 0; y < h; y++ ) {
+        Uint32 * row = (Uint32 *)((Uint8 *)s->pixels + y * s->pitch);
+
+        for ( int x = 0; x < w; x++ ) {
+            Uint32 pa = 0;
+            Uint32 pb = 0;
+            if ( x < sa->w && y < sa->h ) {
+                pa = ((Uint32 *)((Uint8 *)sa->pixels + y * sa->pitch))[x];
+            }
+            if ( x < sb->w && y < sb->h ) {
+                pb = ((Uint32 *)((Uint8 *)sb->pixels + y * sb->pitch))[x];
+            }
+
+            row[x] = pa;
+            row[w + x] = pb;
+            row[w * 2 + x] = pa == pb ? pb : highlight;
+        }
+    }
+
+    const char * base = strrchr(diff->b->name, '/');
+    char name[512];
+    snprintf(name, sizeof(name), "%s/%s.diff.%s",
+             options->directory ? options->directory : ".",
+             base ? base + 1 : diff->b->name,
+             options->extension ? options->extension : "bmp");
+
+    // Views are compared in parallel already.
+    if ( SaveImage(s, name, 1) ) {
+        Report(diff, "  saved %s\n", name);
+    } else {
+        Report(diff, "  Error: could not save '%s': %s\n", name, SDL_GetError());
+    }
+
+    SDL_DestroySurface(s);
+    SDL_DestroySurface(sa);
+    SDL_DestroySurface(sb);
+}
+
+
+
+static void
+DiffViews(ViewDiff * diff, const DiffOptions * options)
+{
+    Source a_data, b_data;
+    bool same = false;
+    if ( diff->a->size == diff->b->size && LoadResource(diff->a, &a_data) ) {
+        if ( LoadResource(diff->b, &b_data) ) {
+            same = HashBytes(a_data.data, a_data.size) == HashBytes(b_data.data, b_data.size);
+            CloseSource(&b_data);
+        }
+        CloseSource(&a_data);
+    }
+
+    if ( same ) {
+        diff->status = DIFF_SAME;
+        return;
+    }
+
+    diff->status = DIFF_CHANGED;
+    Report(diff, "%s: changed (%zu -> %zu bytes)\n",
+           diff->b->name, diff->a->size, diff->b->size);
+
+    View * a = SDL_malloc(sizeof(*a));
+    View * b = SDL_malloc(sizeof(*b));
+
+    if ( !ParseViewResource(a, diff->a) || !ParseViewResource(b, diff->b) ) {
+        Report(diff, "  not a valid View\n");
+        ReleaseView(a);
+        SDL_free(a);
+        SDL_free(b);
+        return;
+    }
+
+    Uint8 * pixels_a = SDL_malloc(MAX_CEL_WIDTH * MAX_CEL_HEIGHT);
+    Uint8 * pixels_b = SDL_malloc(MAX_CEL_WIDTH * MAX_CEL_HEIGHT);
+    int num_loops = SDL_max(a->num_loops, b->num_loops);
+    for ( int i = 0; i < num_loops; i++ ) {
+        if ( i >= a->num_loops ) {
+            Report(diff, "  loop %d: added\n", i);
+            continue;
+        } else if ( i >= b->num_loops ) {
+            Report(diff, "  loop %d: removed\n", i);
+            continue;
+        }
+
+        int num_cels_a = a->loops[i].num_cels;
+        int num_cels_b = b->loops[i].num_cels;
+        if ( num_cels_a != num_cels_b ) {
+            Report(diff, "  loop %d: %d cels -> %d cels\n", i, num_cels_a, num_cels_b);
+        }
+
+        for ( int j = 0; j < SDL_min(num_cels_a, num_cels_b); j++ ) {
+            DiffCels(diff, a, b, i, j, pixels_a, pixels_b);
+        }
+    }
+    SDL_free(pixels_a);
+    SDL_free(pixels_b);
+
+    if ( options->images ) {
+        SaveDiffImage(diff, a, b, options);
+    }
+
+    ReleaseView(a);
+    ReleaseView(b);
+    SDL_free(a);
+    SDL_free(b);
+}
+
+
+
+static void
+DiffWork(int index, void * context)
+{
+    DiffJob * job = context;
+    ViewDiff * diff = &job->diffs[index];
+
+    if ( diff->a && diff->b ) {
+        DiffViews(diff, job->options);
+    } else if ( diff->a ) {
+        diff->status = DIFF_ONLY_A;
+        Report(diff, "%s: removed\n", diff->a->name);
+    } else {
+        diff->status = DIFF_ONLY_B;
+        Report(diff, "%s: added\n", diff->b->name);
+    }
+}
+
+
+
+/// Compare the Views of two games (or two View files). Views whose resource
+/// bytes hash the same are skipped; the rest are decoded and compared cel by
+/// cel. Returns the number of Views that differ.
+int
+DiffGames(const char * path_a, const char * path_b, const DiffOptions * options)
+{
+    if ( options->images && options->directory
+        && !SDL_CreateDirectory(options->directory) ) {
+        printf("Error: could not create '%s': %s\n", options->directory, SDL_GetError());
+        return -1;
+    }
+
+    ViewList list_a = { 0 };
+    ViewList list_b = { 0 };
+    if ( !CollectViews(&list_a, path_a) || !CollectViews(&list_b, path_b) ) {
+        FreeViewList(&list_a);
+        FreeViewList(&list_b);
+        return -1;
+    }
+
+    // Pair up Views by number. Two loose View files are compared directly.
+    const ViewResource ** by_number_a = SDL_calloc(MAX_RESOURCE_NUMBER, sizeof(*by_number_a));
+    const ViewResource ** by_number_b = SDL_calloc(MAX_RESOURCE_NUMBER, sizeof(*by_number_b));
+
+    if ( list_a.num_views == 1 && list_a.views[0].number == -1
+        && list_b.num_views == 1 && list_b.views[0].number == -1 ) {
+        by_number_a[0] = &list_a.views[0];
+        by_number_b[0] = &list_b.views[0];
+    } else {
+        for ( int i = 0; i < list_a.num_views; i++ ) {
+            int number = list_a.views[i].number;
+            if ( number >= 0 && number < MAX_RESOURCE_NUMBER ) {
+                by_number_a[number] = &list_a.views[i];
+            }
+        }
+        for ( int i = 0; i < list_b.num_views; i++ ) {
+            int number = list_b.views[i].number;
+            if ( number >= 0 && number < MAX_RESOURCE_NUMBER ) {
+                by_number_b[number] = &list_b.views[i];
+            }
+        }
+    }
+
+    ViewDiff * diffs = SDL_calloc(MAX_RESOURCE_NUMBER, sizeof(*diffs));
+    int num_diffs = 0;
+    for ( int i = 0; i < MAX_RESOURCE_NUMBER; i++ ) {
+        if ( by_number_a[i] || by_number_b[i] ) {
+            diffs[num_diffs].a = by_number_a[i];
+            diffs[num_diffs].b = by_number_b[i];
+            num_diffs++;
+        }
+    }
+    SDL_free(by_number_a);
+    SDL_free(by_number_b);
+
+    DiffJob job = { .diffs = diffs, .options = options };
+    RunParallel(num_diffs, options->num_threads, DiffWork, &job);
+
+    int counts[4] = { 0 };
+    for ( int i = 0; i < num_diffs; i++ ) {
+        counts[diffs[i].status]++;
+        if ( diffs[i].report ) {
+            printf("%s", diffs[i].report);
+            SDL_free(diffs[i].report);
+        }
+    }
+
+    printf("%d Views compared: %d unchanged, %d changed, %d removed, %d added\n",
+           num_diffs,
+           counts[DIFF_SAME],
+           counts[DIFF_CHANGED],
+           counts[DIFF_ONLY_A],
+           counts[DIFF_ONLY_B]);
+
+    SDL_free(diffs);
+    FreeViewList(&list_a);
+    FreeViewList(&list_b);
+
+    return num_diffs - counts[DIFF_SAME];
+}
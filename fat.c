@@ -0,0 +1,485 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Read-only FAT12/FAT16 disk image reader, so games can be read straight from
+// floppy and hard disk images.
+//
+
+#include "agi.h"
+#include <ctype.h>
+
+#define DIR_ENTRY_SIZE 32
+#define ATTR_VOLUME_ID 0x08
+#define ATTR_DIRECTORY 0x10
+#define ATTR_LONG_NAME 0x0F
+#define MAX_DEPTH 8
+
+
+
+typedef struct {
+    char name[13]; // "NAME.EXT"
+    Uint8 attributes;
+    Uint16 cluster;
+    Uint32 size;
+} DirEntry;
+
+
+
+typedef struct {
+    const FatImage * image;
+    const char * image_path;
+    DirEntry * entries;
+    int num_entries;
+} Directory;
+
+
+
+/// Geometry of DOS 1.x floppies, which have no BIOS Parameter Block.
+static const struct {
+    size_t size;
+    int sectors_per_cluster;
+    int root_entries;
+    int sectors_per_fat;
+} dos1_formats[] = {
+    { 163840, 1, 64, 1 },  // 160K
+    { 184320, 1, 64, 2 },  // 180K
+    { 327680, 2, 112, 1 }, // 320K
+    { 368640, 2, 112, 2 }, // 360K
+};
+
+
+
+static Uint16
+Get16(const Uint8 * p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+
+
+static Uint32
+Get32(const Uint8 * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+
+
+static bool
+IsPowerOfTwo(int n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+
+
+/// Check `data` for a FAT12 or FAT16 file system and read its layout.
+bool
+OpenFatImage(FatImage * image, const Source * source)
+{
+    const Uint8 * data = source->data;
+    size_t size = source->size;
+    if ( size < 512 || size % 512 != 0 ) {
+        return false;
+    }
+
+    int bytes_per_sector = Get16(data + 11);
+    int sectors_per_cluster = data[13];
+    int reserved_sectors = Get16(data + 14);
+    int num_fats = data[16];
+    int root_entries = Get16(data + 17);
+    Uint32 total_sectors = Get16(data + 19);
+    int sectors_per_fat = Get16(data + 22);
+
+    if ( total_sectors == 0 ) {
+        total_sectors = Get32(data + 32);
+    }
+
+    bool has_bpb = data[510] == 0x55 && data[511] == 0xAA
+        && (bytes_per_sector == 512 || bytes_per_sector == 1024
+            || bytes_per_sector == 2048 || bytes_per_sector == 4096)
+        && IsPowerOfTwo(sectors_per_cluster)
+        && reserved_sectors > 0
+        && (num_fats == 1 || num_fats == 2)
+        && root_entries > 0 // FAT32 has no fixed root directory.
+        && sectors_per_fat > 0
+        && total_sectors > 0;
+
+    if ( !has_bpb ) {
+        // Try the DOS 1.x floppy formats, identified by size and the media
+        // byte at the start of the FAT.
+        int i;
+        for ( i = 0; i < (int)SDL_arraysize(dos1_formats); i++ ) {
+            if ( dos1_formats[i].size == size ) {
+                break;
+            }
+        }
+
+        if ( i == SDL_arraysize(dos1_formats) || data[512] < 0xFC
+            || data[513] != 0xFF || data[514] != 0xFF ) {
+            return false;
+        }
+
+        bytes_per_sector = 512;
+        sectors_per_cluster = dos1_formats[i].sectors_per_cluster;
+        reserved_sectors = 1;
+        num_fats = 2;
+        root_entries = dos1_formats[i].root_entries;
+        sectors_per_fat = dos1_formats[i].sectors_per_fat;
+        total_sectors = (Uint32)(size / 512);
+    }
+
+    int root_sectors = (root_entries * DIR_ENTRY_SIZE + bytes_per_sector - 1)
+                     / bytes_per_sector;
+    Uint32 first_data_sector = reserved_sectors
+                             + num_fats * sectors_per_fat
+                             + root_sectors;
+    if ( first_data_sector >= total_sectors ) {
+        return false;
+    }
+
+    SDL_zerop(image);
+    image->source = source;
+    image->data = data;
+    image->size = size;
+    image->id = source->id;
+    image->bytes_per_cluster = bytes_per_sector * sectors_per_cluster;
+    image->num_clusters = (total_sectors - first_data_sector) / sectors_per_cluster;
+    image->fat_offset = (size_t)reserved_sectors * bytes_per_sector;
+    image->root_offset = image->fat_offset
+                       + (size_t)num_fats * sectors_per_fat * bytes_per_sector;
+    image->root_entries = root_entries;
+    image->data_offset = (size_t)first_data_sector * bytes_per_sector;
+
+    if ( image->num_clusters < 4085 ) {
+        image->fat_bits = 12;
+    } else if ( image->num_clusters < 65525 ) {
+        image->fat_bits = 16;
+    } else {
+        return false;
+    }
+
+    return image->root_offset + root_entries * DIR_ENTRY_SIZE <= size;
+}
+
+
+
+/// Get the cluster following `cluster` in its chain, or 0 at the end of the
+/// chain (or if the FAT is damaged).
+static Uint32
+NextCluster(const FatImage * image, Uint32 cluster)
+{
+    Uint32 next;
+
+    if ( image->fat_bits == 12 ) {
+        size_t offset = image->fat_offset + cluster + cluster / 2;
+        if ( offset + 1 >= image->size ) {
+            return 0;
+        }
+        next = Get16(image->data + offset);
+        next = cluster & 1 ? next >> 4 : next & 0x0FFF;
+    } else {
+        size_t offset = image->fat_offset + cluster * 2;
+        if ( offset + 1 >= image->size ) {
+            return 0;
+        }
+        next = Get16(image->data + offset);
+    }
+
+    if ( next < 2 || next >= image->num_clusters + 2 ) {
+        return 0; // End of chain, free, bad or reserved.
+    }
+
+    return next;
+}
+
+
+
+static const Uint8 *
+ClusterData(const FatImage * image, Uint32 cluster)
+{
+    size_t offset = image->data_offset + (size_t)(cluster - 2) * image->bytes_per_cluster;
+    if ( offset + image->bytes_per_cluster > image->size ) {
+        return NULL;
+    }
+
+    return image->data + offset;
+}
+
+
+
+/// Read `size` bytes of the cluster chain starting at `cluster` as a source.
+/// If the chain is contiguous the source is a span of the image; otherwise it
+/// is copied into a new buffer. Either way, its identity is that of the image
+/// and the chain.
+static bool
+ReadChain(const FatImage * image, Uint32 cluster, size_t size, Source * source)
+{
+    if ( cluster < 2 || ClusterData(image, cluster) == NULL ) {
+        return false;
+    }
+
+    Uint64 id = ResourceKey(image->id, cluster, size);
+
+    // Walk the chain to see whether it's contiguous.
+    size_t num_clusters = (size + image->bytes_per_cluster - 1) / image->bytes_per_cluster;
+    bool contiguous = true;
+    Uint32 c = cluster;
+    for ( size_t i = 1; i < num_clusters; i++ ) {
+        Uint32 next = NextCluster(image, c);
+        if ( next == 0 ) {
+            return false; // Chain is shorter than the file.
+        }
+        if ( next != c + 1 ) {
+            contiguous = false;
+        }
+        c = next;
+    }
+
+    if ( contiguous && ClusterData(image, cluster) + size <= image->data + image->size ) {
+        SpanSource(source, image->source, ClusterData(image, cluster) - image->data, size);
+        source->id = id;
+        return true;
+    }
+
+    Uint8 * buffer = SDL_malloc(SDL_max(size, 1));
+    size_t copied = 0;
+    for ( c = cluster; copied < size; c = NextCluster(image, c) ) {
+        const Uint8 * src = ClusterData(image, c);
+        if ( c == 0 || src == NULL ) {
+            SDL_free(buffer);
+            return false;
+        }
+
+        size_t n = SDL_min(size - copied, (size_t)image->bytes_per_cluster);
+        memcpy(buffer + copied, src, n);
+        copied += n;
+    }
+
+    OwnedSource(source, buffer, size, id);
+    return true;
+}
+
+
+
+/// Read the entries of a directory from its raw 32-byte records. Returns
+/// false once the end-of-directory marker is reached.
+static bool
+ReadEntries(Directory * dir, const Uint8 * records, int num_records)
+{
+    for ( int i = 0; i < num_records; i++ ) {
+        const Uint8 * r = records + i * DIR_ENTRY_SIZE;
+
+        if ( r[0] == 0x00 ) {
+            return false; // No more entries.
+        }
+
+        if ( r[0] == 0xE5 || r[0] == '.' || r[11] == ATTR_LONG_NAME
+            || (r[11] & ATTR_VOLUME_ID) ) {
+            continue; // Deleted, "." or "..", long name or volume label.
+        }
+
+        DirEntry * entry = &dir->entries[dir->num_entries++];
+        int n = 0;
+        for ( int j = 0; j < 8 && r[j] != ' '; j++ ) {
+            entry->name[n++] = toupper(r[j]);
+        }
+        if ( r[8] != ' ' ) {
+            entry->name[n++] = '.';
+            for ( int j = 8; j < 11 && r[j] != ' '; j++ ) {
+                entry->name[n++] = toupper(r[j]);
+            }
+        }
+        entry->name[n] = '\0';
+        entry->attributes = r[11];
+        entry->cluster = Get16(r + 26);
+        entry->size = Get32(r + 28);
+    }
+
+    return true;
+}
+
+
+
+/// Read the root directory (if `parent` is NULL) or a subdirectory.
+static void
+ReadDirectory(Directory * dir, const FatImage * image, const DirEntry * parent)
+{
+    SDL_zerop(dir);
+    dir->image = image;
+
+    if ( parent == NULL ) {
+        dir->entries = SDL_calloc(image->root_entries, sizeof(DirEntry));
+        ReadEntries(dir, image->data + image->root_offset, image->root_entries);
+        return;
+    }
+
+    // Subdirectories have no recorded size, so count the clusters in the
+    // chain (bounded, in case the FAT has a loop).
+    int per_cluster = image->bytes_per_cluster / DIR_ENTRY_SIZE;
+    Uint32 num_clusters = 0;
+    for ( Uint32 c = parent->cluster; c != 0 && num_clusters < image->num_clusters; ) {
+        num_clusters++;
+        c = NextCluster(image, c);
+    }
+
+    dir->entries = SDL_calloc(num_clusters * per_cluster + 1, sizeof(DirEntry));
+
+    Uint32 c = parent->cluster;
+    for ( Uint32 n = 0; n < num_clusters; n++ ) {
+        const Uint8 * records = ClusterData(image, c);
+        if ( records == NULL || !ReadEntries(dir, records, per_cluster) ) {
+            break;
+        }
+        c = NextCluster(image, c);
+    }
+}
+
+
+
+static const DirEntry *
+FindEntry(const Directory * dir, const char * name)
+{
+    for ( int i = 0; i < dir->num_entries; i++ ) {
+        if ( SDL_strcasecmp(dir->entries[i].name, name) == 0 ) {
+            return &dir->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/// GameFileFunc for files in a directory of the image.
+static bool
+LoadImageFile(void * context, const char * name, Source * source, char * path)
+{
+    Directory * dir = context;
+    snprintf(path, MAX_PATH_LENGTH, "%s", dir->image_path);
+    const DirEntry * entry = FindEntry(dir, name);
+
+    if ( entry == NULL || (entry->attributes & ATTR_DIRECTORY) ) {
+        return false;
+    }
+
+    return ReadChain(dir->image, entry->cluster, entry->size, source);
+}
+
+
+
+static void
+CollectDirectory(ViewList * list,
+                 const FatImage * image,
+                 const char * image_path,
+                 const DirEntry * parent,
+                 const char * prefix,
+                 ResourceType type,
+                 int depth)
+{
+    Directory dir;
+    ReadDirectory(&dir, image, parent);
+    dir.image_path = image_path;
+
+    const char * dir_name = type == RESOURCE_VIEW ? "VIEWDIR" : "PICDIR";
+    const char * loose_prefix = type == RESOURCE_VIEW ? "VIEW." : "PIC.";
+    char v3_id[MAX_GAME_ID];
+    bool is_v3 = false;
+    for ( int i = 0; i < dir.num_entries && !is_v3; i++ ) {
+        is_v3 = !(dir.entries[i].attributes & ATTR_DIRECTORY)
+             && GetV3GameID(dir.entries[i].name, v3_id);
+    }
+
+    if ( FindEntry(&dir, dir_name) ) {
+        CollectGameResources(list, prefix, type, NULL, LoadImageFile, &dir);
+    } else if ( is_v3 ) {
+        CollectGameResources(list, prefix, type, v3_id, LoadImageFile, &dir);
+    } else if ( type == RESOURCE_VIEW && FindEntry(&dir, "RESOURCE.MAP") ) {
+        CollectGameResources(list, prefix, type, NULL, LoadImageFile, &dir);
+    }
+
+    for ( int i = 0; i < dir.num_entries; i++ ) {
+        const DirEntry * entry = &dir.entries[i];
+        char name[256];
+        snprintf(name, sizeof(name), "%s%s", prefix, entry->name);
+
+        if ( entry->attributes & ATTR_DIRECTORY ) {
+            if ( depth < MAX_DEPTH ) {
+                strncat(name, ".", sizeof(name) - strlen(name) - 1);
+                CollectDirectory(list, image, image_path, entry, name, type, depth + 1);
+            }
+        } else if ( strncmp(entry->name, loose_prefix, strlen(loose_prefix)) == 0 ) {
+            // A loose resource file.
+            Source file;
+            if ( !ReadChain(image, entry->cluster, entry->size, &file) ) {
+                continue;
+            }
+            AddSource(list, &file);
+
+            ViewResource * view = AddView(list);
+            view->number = -1;
+            view->key = file.id;
+            if ( type == RESOURCE_VIEW ) {
+                SetViewData(view, file.data, file.size);
+            } else {
+                view->data = file.data;
+                view->size = file.size;
+            }
+            SetViewSource(view, &file);
+            snprintf(view->name, sizeof(view->name), "%s", name);
+            SetViewInputs(view, image_path, NULL);
+        }
+    }
+
+    SDL_free(dir.entries);
+}
+
+
+
+/// Add the resources of a type from every game (a directory with VIEWDIR,
+/// PICDIR, a v3 combined directory or RESOURCE.MAP) and loose resource file
+/// found in the image. Resources are named after the image and the
+/// directories they were found in, e.g. "disk1.img.KQ1.VIEW.014", so output
+/// is saved next to the image.
+bool
+CollectFatResources(ViewList * list,
+                    const FatImage * image,
+                    const char * path,
+                    ResourceType type)
+{
+    int num_views = list->num_views;
+
+    char prefix[256];
+    snprintf(prefix, sizeof(prefix), "%s.", path);
+    CollectDirectory(list, image, path, NULL, prefix, type, 0);
+
+    if ( list->num_views == num_views ) {
+        printf("Error: no %s found in disk image '%s'\n",
+               type == RESOURCE_VIEW ? "Views" : "pictures", path);
+        return false;
+    }
+
+    return true;
+}
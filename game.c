@@ -0,0 +1,664 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#include "agi.h"
+#include <ctype.h>
+#include <errno.h>
+
+#define MAX_VOLS 16
+
+
+
+/// Keep a source open for as long as the list, which closes it when freed.
+/// The caller's copy stays usable until closed, which then only lets go of
+/// its pin on a cached file: cached files stay in the cache, not the list.
+void
+AddSource(ViewList * list, Source * source)
+{
+    if ( source->kind == SOURCE_SPAN || source->kind == SOURCE_CACHED ) {
+        return;
+    }
+
+    list->sources = SDL_realloc(list->sources,
+                                (list->num_sources + 1) * sizeof(Source));
+    list->sources[list->num_sources++] = *source;
+    source->kind = SOURCE_SPAN;
+}
+
+
+
+/// Keep memory made while reading resources, such as decompressed data, for
+/// as long as the list.
+const Uint8 *
+AddBuffer(ViewList * list, void * buffer, size_t size, Uint64 id)
+{
+    Source source;
+    OwnedSource(&source, buffer, size, id);
+    AddSource(list, &source);
+
+    return source.data;
+}
+
+
+
+ViewResource *
+AddView(ViewList * list)
+{
+    list->views = SDL_realloc(list->views,
+                              (list->num_views + 1) * sizeof(ViewResource));
+    ViewResource * view = &list->views[list->num_views++];
+    SDL_zerop(view);
+
+    return view;
+}
+
+
+
+/// Record the files a View was read from, for dependency tracking. If the two
+/// are the same (e.g. a disk image), it is only recorded once.
+void
+SetViewInputs(ViewResource * view, const char * input1, const char * input2)
+{
+    view->num_inputs = 0;
+
+    if ( input1 ) {
+        snprintf(view->inputs[view->num_inputs++], MAX_PATH_LENGTH, "%s", input1);
+    }
+
+    if ( input2 && (input1 == NULL || strcmp(input1, input2) != 0) ) {
+        snprintf(view->inputs[view->num_inputs++], MAX_PATH_LENGTH, "%s", input2);
+    }
+}
+
+
+
+/// Set a loose View file's data, recognising SCI0 patch files by their
+/// header.
+void
+SetViewData(ViewResource * view, const Uint8 * data, size_t size)
+{
+    size_t offset;
+    if ( IsSCIViewPatch(data, size, &offset) ) {
+        view->format = VIEW_SCI0;
+        data += offset;
+        size -= offset;
+    }
+
+    view->data = data;
+    view->size = size;
+}
+
+
+
+/// Once a View's data is set, refer to it by its place in `source` instead if
+/// that is a cached file, so the file can be closed until the View is loaded.
+void
+SetViewSource(ViewResource * view, const Source * source)
+{
+    if ( source->file && view->data >= source->data
+        && view->data + view->size <= source->data + source->size ) {
+        view->file = source->file;
+        view->offset = source->offset + (size_t)(view->data - source->data);
+        view->data = NULL;
+    }
+}
+
+
+
+/// Get a resource's data as a source, to be closed once done with. Data in a
+/// cached file is pinned until then.
+bool
+LoadResource(const ViewResource * resource, Source * source)
+{
+    if ( resource->file == NULL ) {
+        SDL_zerop(source);
+        source->data = resource->data;
+        source->size = resource->size;
+        source->id = resource->key;
+        source->kind = SOURCE_SPAN;
+        return true;
+    }
+
+    Source file;
+    if ( !PinCachedFile(resource->file, &file) ) {
+        return false;
+    }
+
+    if ( resource->offset + resource->size > file.size ) {
+        CloseSource(&file);
+        return SDL_SetError("'%s' is cut short", resource->name);
+    }
+
+    *source = file;
+    source->data += resource->offset;
+    source->size = resource->size;
+    source->id = resource->key;
+    source->offset = resource->offset;
+
+    return true;
+}
+
+
+
+/// Open a file from a game directory, trying both upper and lower case names,
+/// since games copied from DOS disks may have either.
+static bool
+LoadGameFile(void * context, const char * name, Source * source, char * path)
+{
+    const char * dir = context;
+
+    snprintf(path, MAX_PATH_LENGTH, "%s/%s", dir, name);
+    if ( OpenCachedSource(source, path) ) {
+        return true;
+    }
+
+    char lower[64] = { 0 };
+    for ( int i = 0; name[i] && i < (int)sizeof(lower) - 1; i++ ) {
+        lower[i] = tolower(name[i]);
+    }
+
+    snprintf(path, MAX_PATH_LENGTH, "%s/%s", dir, lower);
+    return OpenCachedSource(source, path);
+}
+
+
+
+/// The names of each resource type's directory file and resources, and their
+/// section in an AGI v3 combined directory, which begins with the offsets of
+/// its LOGDIR, PICDIR, VIEWDIR and SNDDIR sections.
+static const struct {
+    const char * dir_name;
+    const char * name;
+    int v3_section;
+} resource_types[] = {
+    [RESOURCE_VIEW]    = { "VIEWDIR", "VIEW", 2 },
+    [RESOURCE_PICTURE] = { "PICDIR", "PIC", 1 },
+};
+
+
+
+/// If `name` is an AGI v3 combined directory file ("KQ4DIR", "GRDIR", etc.),
+/// copy its game ID, which prefixes the game's VOL files, to `id`.
+bool
+GetV3GameID(const char * name, char * id) // MAX_GAME_ID
+{
+    static const char * v2_dirs[] = { "LOGDIR", "PICDIR", "VIEWDIR", "SNDDIR" };
+
+    size_t length = strlen(name);
+    if ( length < 4 || length - 3 >= MAX_GAME_ID
+        || SDL_strcasecmp(name + length - 3, "DIR") != 0
+        || SDL_strchr(name, '.') ) {
+        return false;
+    }
+
+    for ( int i = 0; i < (int)SDL_arraysize(v2_dirs); i++ ) {
+        if ( SDL_strcasecmp(name, v2_dirs[i]) == 0 ) {
+            return false;
+        }
+    }
+
+    for ( size_t i = 0; i < length - 3; i++ ) {
+        id[i] = toupper(name[i]);
+    }
+    id[length - 3] = '\0';
+
+    return true;
+}
+
+
+
+/// Expand AGI v3 LZW data. Codes are read least significant bit first,
+/// starting at 9 bits and widening as the table fills, to at most 11 bits.
+/// Code 0x100 resets the table and 0x101 ends the data. Returns false if the
+/// data is corrupt or does not expand to exactly `out_size` bytes.
+static bool
+ExpandLZW(const Uint8 * in, size_t in_size, Uint8 * out, size_t out_size)
+{
+    enum { TABLE_SIZE = 4096, MAX_BITS = 11 };
+
+    Uint16 * prefix = SDL_malloc(TABLE_SIZE * sizeof(*prefix));
+    Uint8 * suffix = SDL_malloc(TABLE_SIZE);
+    Uint8 * stack = SDL_malloc(TABLE_SIZE);
+    if ( prefix == NULL || suffix == NULL || stack == NULL ) {
+        SDL_free(prefix);
+        SDL_free(suffix);
+        SDL_free(stack);
+        return false;
+    }
+
+    size_t pos = 0;
+    Uint32 bit_buffer = 0;
+    int bit_count = 0;
+    int bits = 9;
+
+    #define READ_CODE(code) \
+        while ( bit_count < bits && pos < in_size ) { \
+            bit_buffer |= (Uint32)in[pos++] << bit_count; \
+            bit_count += 8; \
+        } \
+        if ( bit_count < bits ) { \
+            code = 0x101; \
+        } else { \
+            code = bit_buffer & ((1 << bits) - 1); \
+            bit_buffer >>= bits; \
+            bit_count -= bits; \
+        }
+
+    // The data starts with a reset code, which is read as the first 'previous'
+    // code, hence the first entry defined being 257 rather than 258.
+    int next = 257;
+    int old, code;
+    READ_CODE(old);
+    int first = old;
+    READ_CODE(code);
+
+    size_t n = 0;
+    bool ok = true;
+    while ( n < out_size && code != 0x101 ) {
+        if ( code == 0x100 ) {
+            next = 258;
+            bits = 9;
+            READ_CODE(old);
+            if ( old >= 0x100 ) {
+                break;
+            }
+            first = old;
+            out[n++] = old;
+            READ_CODE(code);
+            continue;
+        }
+
+        // Collect the code's string backwards on the stack.
+        int sp = 0;
+        int string = code;
+        if ( code >= next ) {
+            stack[sp++] = first; // The code being defined: old's string + its
+            string = old;        // own first byte.
+        }
+
+        while ( string > 0xFF ) {
+            if ( string >= next || string == 0x100 || sp >= TABLE_SIZE - 1 ) {
+                ok = false;
+                break;
+            }
+            stack[sp++] = suffix[string];
+            string = prefix[string];
+        }
+        if ( !ok ) {
+            break;
+        }
+        stack[sp++] = string;
+        first = string;
+
+        while ( sp > 0 && n < out_size ) {
+            out[n++] = stack[--sp];
+        }
+
+        if ( next > (1 << bits) - 2 && bits < MAX_BITS ) {
+            bits++;
+        }
+
+        if ( next < TABLE_SIZE ) {
+            prefix[next] = old;
+            suffix[next] = first;
+            next++;
+        }
+
+        old = code;
+        READ_CODE(code);
+    }
+
+    #undef READ_CODE
+
+    SDL_free(prefix);
+    SDL_free(suffix);
+    SDL_free(stack);
+
+    return ok && n == out_size;
+}
+
+
+
+/// Expand an AGI v3 picture, in which the color operands of the 'set visual
+/// color' (0xF0) and 'set priority color' (0xF2) commands are stored as single
+/// nibbles, leaving everything after them shifted by half a byte. Returns
+/// the expanded size.
+static size_t
+ExpandPictureNibbles(const Uint8 * in, size_t in_size, Uint8 * out, size_t out_size)
+{
+    size_t pos = 0;
+    bool half = false; // Reading starts at the low nibble of in[pos].
+    size_t n = 0;
+
+    while ( n < out_size && pos < in_size ) {
+        Uint8 byte;
+        if ( half ) {
+            if ( pos + 1 >= in_size ) {
+                break;
+            }
+            byte = (in[pos] << 4) | (in[pos + 1] >> 4);
+        } else {
+            byte = in[pos];
+        }
+        pos++;
+        out[n++] = byte;
+
+        if ( byte == 0xFF ) {
+            break;
+        }
+
+        if ( (byte == 0xF0 || byte == 0xF2) && n < out_size && pos < in_size ) {
+            if ( half ) {
+                out[n++] = in[pos++] & 0x0F;
+            } else {
+                out[n++] = in[pos] >> 4;
+            }
+            half = !half;
+        }
+    }
+
+    return n;
+}
+
+
+
+/// Get the data of a v3 resource, whose header is 0x12 0x34, the VOL number,
+/// the expanded size, and the stored size. A set high bit in the VOL number
+/// marks a nibble-packed picture; otherwise the data is LZW compressed if the
+/// two sizes differ.
+static const Uint8 *
+GetV3ResourceData(ViewList * list,
+                  const Uint8 * header,
+                  size_t available,
+                  Uint64 key,
+                  size_t * size)
+{
+    size_t expanded = header[3] | (header[4] << 8);
+    size_t stored = SDL_min((size_t)(header[5] | (header[6] << 8)), available);
+    const Uint8 * data = header + 7;
+
+    if ( !(header[2] & 0x80) && expanded == stored ) {
+        *size = stored;
+        return data;
+    }
+
+    Uint8 * out = SDL_malloc(expanded);
+    if ( out == NULL ) {
+        return NULL;
+    }
+
+    if ( header[2] & 0x80 ) {
+        *size = ExpandPictureNibbles(data, stored, out, expanded);
+    } else if ( ExpandLZW(data, stored, out, expanded) ) {
+        *size = expanded;
+    } else {
+        SDL_free(out);
+        return NULL;
+    }
+
+    return AddBuffer(list, out, *size, key);
+}
+
+
+
+/// Add every resource of a type listed in a game's directory. Each directory
+/// entry is three bytes: the high nibble of the first is the VOL file number,
+/// and the remaining 20 bits are the offset of the resource in that VOL file.
+/// v2 games have a directory file per type (VIEWDIR, PICDIR) and VOL files
+/// named VOL.n; v3 games, given by `v3_id`, have one combined directory file
+/// and VOL files prefixed with the ID, and may compress resources. Game files
+/// are read with `load`; resource names are prefixed with `prefix`.
+bool
+CollectGameResources(ViewList * list,
+                     const char * prefix,
+                     ResourceType type,
+                     const char * v3_id,
+                     GameFileFunc load,
+                     void * context)
+{
+    const char * dir_name = resource_types[type].dir_name;
+    char v3_dir_name[MAX_GAME_ID + 8];
+    if ( v3_id ) {
+        snprintf(v3_dir_name, sizeof(v3_dir_name), "%sDIR", v3_id);
+        dir_name = v3_dir_name;
+    }
+
+    Source dir_source;
+    char dir_path[MAX_PATH_LENGTH];
+    char vol_paths[MAX_VOLS][MAX_PATH_LENGTH];
+    if ( !load(context, dir_name, &dir_source, dir_path) ) {
+        if ( type == RESOURCE_VIEW && CollectSCIViews(list, prefix, load, context) ) {
+            return true;
+        }
+
+        if ( type == RESOURCE_VIEW ) {
+            printf("Error: could not open VIEWDIR or RESOURCE.MAP in '%s'\n", prefix);
+        } else {
+            printf("Error: could not open %s in '%s'\n", dir_name, prefix);
+        }
+        return false;
+    }
+
+    AddSource(list, &dir_source);
+    const Uint8 * dir = dir_source.data;
+    size_t dir_size = dir_source.size;
+
+    // The entries of a v3 game's section of the combined directory run up to
+    // the next section, or the end of the file.
+    const Uint8 * entries = dir;
+    size_t entries_size = dir_size;
+    if ( v3_id ) {
+        int section = resource_types[type].v3_section;
+        if ( dir_size < 8 ) {
+            printf("Error: bad %s in '%s'\n", dir_name, prefix);
+            CloseSource(&dir_source);
+            return false;
+        }
+
+        size_t start = dir[section * 2] | (dir[section * 2 + 1] << 8);
+        size_t end = dir[section * 2 + 2] | (dir[section * 2 + 3] << 8);
+        if ( end <= start || end > dir_size ) {
+            end = dir_size;
+        }
+        if ( start > end ) {
+            start = end;
+        }
+
+        entries = dir + start;
+        entries_size = end - start;
+    }
+
+    const char * name = resource_types[type].name;
+    size_t header_size = v3_id ? 7 : 5;
+    Source vols[MAX_VOLS] = { 0 };
+
+    for ( size_t i = 0; i + 2 < entries_size; i += 3 ) {
+        const Uint8 * entry = entries + i;
+        if ( entry[0] == 0xFF && entry[1] == 0xFF && entry[2] == 0xFF ) {
+            continue; // No resource with this number.
+        }
+
+        int number = (int)(i / 3);
+        int vol = entry[0] >> 4;
+        size_t offset = ((entry[0] & 0x0F) << 16) | (entry[1] << 8) | entry[2];
+        char vol_name[MAX_GAME_ID + 16];
+        snprintf(vol_name, sizeof(vol_name), "%sVOL.%d", v3_id ? v3_id : "", vol);
+
+        if ( vols[vol].data == NULL ) {
+            if ( !load(context, vol_name, &vols[vol], vol_paths[vol]) ) {
+                printf("Error: could not open %s in '%s'\n", vol_name, prefix);
+                continue;
+            }
+
+            AddSource(list, &vols[vol]);
+        }
+
+        // Each resource in a VOL file has a header beginning 0x12 0x34 and
+        // the VOL number, followed by the resource length: five bytes in all
+        // for v2, or seven for v3.
+        const Uint8 * header = vols[vol].data + offset;
+        if ( offset + header_size > vols[vol].size
+            || header[0] != 0x12 || header[1] != 0x34 ) {
+            printf("Error: bad %s header for %s %d in '%s'\n",
+                   vol_name, name, number, prefix);
+            continue;
+        }
+
+        size_t available = vols[vol].size - offset - header_size;
+        Uint64 key = ResourceKey(vols[vol].id, offset, 0);
+        size_t size;
+        const Uint8 * data;
+        if ( v3_id ) {
+            data = GetV3ResourceData(list, header, available, key, &size);
+            if ( data == NULL ) {
+                printf("Error: could not expand %s %d in '%s'\n", name, number, prefix);
+                continue;
+            }
+        } else {
+            data = header + 5;
+            size = SDL_min((size_t)(header[3] | (header[4] << 8)), available);
+        }
+
+        ViewResource * view = AddView(list);
+        view->number = number;
+        view->data = data;
+        view->size = size;
+        view->key = key;
+        SetViewSource(view, &vols[vol]);
+        snprintf(view->name, sizeof(view->name), "%s%s.%03d", prefix, name, number);
+        SetViewInputs(view, dir_path, vol_paths[vol]);
+    }
+
+    for ( int i = 0; i < MAX_VOLS; i++ ) {
+        CloseSource(&vols[i]);
+    }
+    CloseSource(&dir_source);
+
+    return true;
+}
+
+
+
+/// Find the combined directory file of an AGI v3 game in a directory.
+static bool
+FindV3GameID(const char * path, char * id) // MAX_GAME_ID
+{
+    int count;
+    char ** names = SDL_GlobDirectory(path, "*DIR", SDL_GLOB_CASEINSENSITIVE, &count);
+    if ( names == NULL ) {
+        return false;
+    }
+
+    bool found = false;
+    for ( int i = 0; i < count && !found; i++ ) {
+        found = GetV3GameID(names[i], id);
+    }
+    SDL_free(names);
+
+    return found;
+}
+
+
+
+/// Add the resources of a type found at `path`, which may be a loose resource
+/// file, a game directory, or a FAT12/FAT16 disk image. Game directories may
+/// be AGI v2 (VIEWDIR, PICDIR), AGI v3 (a combined directory such as KQ4DIR)
+/// or, for Views, SCI0 (RESOURCE.MAP).
+bool
+CollectResources(ViewList * list, const char * path, ResourceType type)
+{
+    SDL_PathInfo info;
+    if ( SDL_GetPathInfo(path, &info) && info.type == SDL_PATHTYPE_DIRECTORY ) {
+        char prefix[256];
+        snprintf(prefix, sizeof(prefix), "%s/", path);
+
+        char v3_id[MAX_GAME_ID];
+        bool is_v3 = false;
+        char dir_path[MAX_PATH_LENGTH];
+        snprintf(dir_path, sizeof(dir_path), "%s/%s", path, resource_types[type].dir_name);
+        if ( !SDL_GetPathInfo(dir_path, NULL) ) {
+            is_v3 = FindV3GameID(path, v3_id);
+        }
+
+        return CollectGameResources(list,
+                                    prefix,
+                                    type,
+                                    is_v3 ? v3_id : NULL,
+                                    LoadGameFile,
+                                    (void *)path);
+    }
+
+    Source file;
+    if ( !OpenCachedSource(&file, path) ) {
+        printf("Error: could not open %s file '%s': %s\n",
+               type == RESOURCE_VIEW ? "view" : "picture", path, strerror(errno));
+        return false;
+    }
+
+    FatImage image;
+    if ( OpenFatImage(&image, &file) ) {
+        bool ok = CollectFatResources(list, &image, path, type);
+        CloseSource(&file);
+        return ok;
+    }
+
+    ViewResource * view = AddView(list);
+    view->number = -1;
+    view->key = file.id;
+    if ( type == RESOURCE_VIEW ) {
+        SetViewData(view, file.data, file.size);
+    } else {
+        view->data = file.data;
+        view->size = file.size;
+    }
+    SetViewSource(view, &file);
+    snprintf(view->name, sizeof(view->name), "%s", path);
+    SetViewInputs(view, path, NULL);
+    CloseSource(&file);
+
+    return true;
+}
+
+
+
+/// Add the View resources found at `path`. See CollectResources.
+bool
+CollectViews(ViewList * list, const char * path)
+{
+    return CollectResources(list, path, RESOURCE_VIEW);
+}
+
+
+
+void
+FreeViewList(ViewList * list)
+{
+    for ( int i = 0; i < list->num_sources; i++ ) {
+        CloseSource(&list->sources[i]);
+    }
+
+    SDL_free(list->sources);
+    SDL_free(list->views);
+    SDL_zerop(list);
+}
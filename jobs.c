@@ -0,0 +1,578 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Job files: describe many outputs in one INI-style file, e.g.
+//
+//  [kq1-large]
+//  input = KQ1
+//  views = 0-10, 14
+//  format = bmp
+//  scale = 3
+//  background = 000000
+//  output = out/%n.x3.bmp
+//
+//  [kq1-anim]
+//  input = KQ1
+//  format = agd
+//
+// Each section is one job. Keys:
+//
+//  input       A View file, game directory or disk image (required).
+//  views       View numbers and ranges to export (default: all).
+//  format      bmp (default), png, dds, ktx2 or agd. DDS and KTX2 files
+//              include a full mip chain.
+//  scale       Integer pixel scale for bmp (default 1).
+//  palette     ega (default), gray, or 16 comma-separated RRGGBB colors.
+//  background  transparent (default) or an RRGGBB color.
+//  output      Output path. %s is replaced with the View's name (e.g.
+//              "KQ1/VIEW.014") and %n with its file name ("VIEW.014").
+//              Defaults to "%s." followed by the format.
+//
+// Jobs are grouped by input: each input is loaded once, and each selected
+// View is parsed and decoded once, with every job's output made from that
+// decode.
+//
+
+#include "agi.h"
+#include <ctype.h>
+
+#define MAX_JOBS 256
+#define MAX_INPUTS MAX_JOBS
+
+
+
+typedef enum {
+    FORMAT_BMP,
+    FORMAT_PNG,
+    FORMAT_DDS,
+    FORMAT_KTX2,
+    FORMAT_AGD,
+} OutputFormat;
+
+
+
+typedef struct {
+    char name[64];
+    char input[256];
+    char output[256];
+    bool views[MAX_RESOURCE_NUMBER]; // Selected View numbers.
+    bool all_views;
+    OutputFormat format;
+    SDL_Color palette[16];
+    RenderOptions render;
+    int input_num;               // Index into the plan's inputs.
+} Job;
+
+
+
+typedef struct {
+    int input_num;
+    int view_num;                // Index into the input's ViewList.
+} WorkItem;
+
+
+
+typedef struct {
+    Job * jobs;
+    int num_jobs;
+    ViewList inputs[MAX_INPUTS];
+    int num_inputs;
+    WorkItem * items;
+    int num_items;
+    SDL_AtomicInt num_decoded;
+    SDL_AtomicInt num_outputs;
+    SDL_AtomicInt num_current;   // Outputs skipped as up to date.
+    SDL_AtomicInt num_errors;
+} Plan;
+
+
+
+static char *
+Trim(char * s)
+{
+    while ( isspace((unsigned char)*s) ) {
+        s++;
+    }
+
+    char * end = s + strlen(s);
+    while ( end > s && isspace((unsigned char)end[-1]) ) {
+        *--end = '\0';
+    }
+
+    return s;
+}
+
+
+
+static bool
+ParseColor(const char * s, SDL_Color * color)
+{
+    char * end;
+    unsigned long rgb = strtoul(s, &end, 16);
+    if ( end - s != 6 ) {
+        return false;
+    }
+
+    color->r = (rgb >> 16) & 0xFF;
+    color->g = (rgb >> 8) & 0xFF;
+    color->b = rgb & 0xFF;
+    color->a = 0xFF;
+
+    return true;
+}
+
+
+
+static bool
+ParsePalette(Job * job, char * value)
+{
+    if ( strcmp(value, "ega") == 0 ) {
+        job->render.palette = NULL;
+        return true;
+    }
+
+    if ( strcmp(value, "gray") == 0 ) {
+        for ( int i = 0; i < 16; i++ ) {
+            Uint8 y = (pal[i].r * 299 + pal[i].g * 587 + pal[i].b * 114) / 1000;
+            job->palette[i] = (SDL_Color){ y, y, y, 0xFF };
+        }
+        job->render.palette = job->palette;
+        return true;
+    }
+
+    int count = 0;
+    for ( char * token = strtok(value, ","); token; token = strtok(NULL, ",") ) {
+        if ( count == 16 || !ParseColor(Trim(token), &job->palette[count]) ) {
+            return false;
+        }
+        count++;
+    }
+
+    job->render.palette = job->palette;
+
+    return count == 16;
+}
+
+
+
+/// Parse a list of View numbers and ranges, e.g. "0-10, 14".
+static bool
+ParseViews(Job * job, char * value)
+{
+    job->all_views = false;
+
+    for ( char * token = strtok(value, ","); token; token = strtok(NULL, ",") ) {
+        char * end;
+        long first = strtol(Trim(token), &end, 10);
+        long last = first;
+        if ( *end == '-' ) {
+            last = strtol(end + 1, &end, 10);
+        }
+
+        if ( *Trim(end) != '\0' || first < 0 || last >= MAX_RESOURCE_NUMBER || first > last ) {
+            return false;
+        }
+
+        for ( long i = first; i <= last; i++ ) {
+            job->views[i] = true;
+        }
+    }
+
+    return true;
+}
+
+
+
+static bool
+SetJobKey(Job * job, const char * key, char * value)
+{
+    if ( strcmp(key, "input") == 0 ) {
+        snprintf(job->input, sizeof(job->input), "%s", value);
+    } else if ( strcmp(key, "output") == 0 ) {
+        snprintf(job->output, sizeof(job->output), "%s", value);
+    } else if ( strcmp(key, "views") == 0 ) {
+        return ParseViews(job, value);
+    } else if ( strcmp(key, "format") == 0 ) {
+        if ( strcmp(value, "bmp") == 0 ) {
+            job->format = FORMAT_BMP;
+        } else if ( strcmp(value, "png") == 0 ) {
+            job->format = FORMAT_PNG;
+        } else if ( strcmp(value, "dds") == 0 ) {
+            job->format = FORMAT_DDS;
+        } else if ( strcmp(value, "ktx2") == 0 ) {
+            job->format = FORMAT_KTX2;
+        } else if ( strcmp(value, "agd") == 0 ) {
+            job->format = FORMAT_AGD;
+        } else {
+            return false;
+        }
+    } else if ( strcmp(key, "scale") == 0 ) {
+        job->render.scale = atoi(value);
+        return job->render.scale >= 1 && job->render.scale <= 16;
+    } else if ( strcmp(key, "palette") == 0 ) {
+        return ParsePalette(job, value);
+    } else if ( strcmp(key, "background") == 0 ) {
+        job->render.opaque = strcmp(value, "transparent") != 0;
+        return !job->render.opaque || ParseColor(value, &job->render.background);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+
+
+static bool
+ReadJobFile(Plan * plan, const char * path)
+{
+    size_t size;
+    char * text = SDL_LoadFile(path, &size);
+    if ( text == NULL ) {
+        printf("Error: could not open job file '%s': %s\n", path, SDL_GetError());
+        return false;
+    }
+
+    bool ok = true;
+    Job * job = NULL;
+    int line_num = 0;
+
+    for ( char * line = text; line && ok; ) {
+        char * next = strchr(line, '\n');
+        if ( next ) {
+            *next++ = '\0';
+        }
+        line_num++;
+
+        line = Trim(line);
+        if ( *line == '\0' || *line == '#' || *line == ';' ) {
+            line = next;
+            continue;
+        }
+
+        if ( *line == '[' ) {
+            char * close = strchr(line, ']');
+            if ( close == NULL || plan->num_jobs == MAX_JOBS ) {
+                ok = false;
+                break;
+            }
+            *close = '\0';
+
+            job = &plan->jobs[plan->num_jobs++];
+            SDL_zerop(job);
+            snprintf(job->name, sizeof(job->name), "%s", Trim(line + 1));
+            job->all_views = true;
+            job->render.scale = 1;
+        } else {
+            char * equals = strchr(line, '=');
+            if ( job == NULL || equals == NULL ) {
+                ok = false;
+                break;
+            }
+            *equals = '\0';
+            ok = SetJobKey(job, Trim(line), Trim(equals + 1));
+        }
+
+        line = next;
+    }
+
+    if ( !ok ) {
+        printf("Error: %s:%d: invalid line\n", path, line_num);
+    }
+
+    for ( int i = 0; i < plan->num_jobs && ok; i++ ) {
+        if ( plan->jobs[i].input[0] == '\0' ) {
+            printf("Error: %s: job [%s] has no input\n", path, plan->jobs[i].name);
+            ok = false;
+        }
+    }
+
+    SDL_free(text);
+
+    return ok;
+}
+
+
+
+/// Group jobs by input, load each input once, and list every View that is
+/// selected by at least one job.
+static void
+MakePlan(Plan * plan)
+{
+    for ( int i = 0; i < plan->num_jobs; i++ ) {
+        Job * job = &plan->jobs[i];
+
+        int j;
+        for ( j = 0; j < i; j++ ) {
+            if ( strcmp(plan->jobs[j].input, job->input) == 0 ) {
+                break;
+            }
+        }
+
+        if ( j < i ) {
+            job->input_num = plan->jobs[j].input_num;
+        } else {
+            job->input_num = plan->num_inputs++;
+            CollectViews(&plan->inputs[job->input_num], job->input);
+        }
+    }
+
+    int max_items = 0;
+    for ( int i = 0; i < plan->num_inputs; i++ ) {
+        max_items += plan->inputs[i].num_views;
+    }
+
+    plan->items = SDL_calloc(SDL_max(max_items, 1), sizeof(WorkItem));
+
+    for ( int i = 0; i < plan->num_inputs; i++ ) {
+        for ( int j = 0; j < plan->inputs[i].num_views; j++ ) {
+            int number = plan->inputs[i].views[j].number;
+
+            for ( int k = 0; k < plan->num_jobs; k++ ) {
+                const Job * job = &plan->jobs[k];
+                if ( job->input_num == i
+                    && (job->all_views || number < 0
+                        || (number < MAX_RESOURCE_NUMBER && job->views[number])) ) {
+                    plan->items[plan->num_items++] = (WorkItem){ i, j };
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+
+/// Expand an output pattern for a View.
+static void
+GetOutputName(const Job * job, const ViewResource * resource, char * name, size_t size)
+{
+    const char * pattern = job->output;
+    if ( *pattern == '\0' ) {
+        static const char * defaults[] = {
+            "%s.bmp", "%s.png", "%s.dds", "%s.ktx2", "%s.agd"
+        };
+        pattern = defaults[job->format];
+    }
+
+    const char * base = strrchr(resource->name, '/');
+    base = base ? base + 1 : resource->name;
+
+    size_t length = 0;
+    for ( const char * p = pattern; *p && length + 1 < size; p++ ) {
+        const char * insert = NULL;
+        if ( p[0] == '%' && p[1] == 's' ) {
+            insert = resource->name;
+        } else if ( p[0] == '%' && p[1] == 'n' ) {
+            insert = base;
+        }
+
+        if ( insert ) {
+            length += snprintf(name + length, size - length, "%s", insert);
+            length = SDL_min(length, size - 1);
+            p++;
+        } else {
+            name[length++] = *p;
+        }
+    }
+
+    name[length] = '\0';
+}
+
+
+
+static bool
+WriteOutput(const Job * job, const DecodedView * decoded, const char * name)
+{
+    if ( job->format == FORMAT_AGD ) {
+        size_t size;
+        Uint8 * data = EncodeDelta(decoded, &size);
+        bool ok = SDL_SaveFile(name, data, size);
+        SDL_free(data);
+
+        return ok;
+    }
+
+    SDL_Surface * s = RenderDecodedView(decoded, &job->render);
+    if ( s == NULL ) {
+        return false;
+    }
+
+    CountSurface(s);
+    bool ok;
+    if ( job->format == FORMAT_PNG ) {
+        ok = SavePNG(s, name, 1);
+    } else if ( job->format == FORMAT_DDS ) {
+        ok = SaveDDS(s, name);
+    } else if ( job->format == FORMAT_KTX2 ) {
+        ok = SaveKTX2(s, name);
+    } else {
+        ok = SDL_SaveBMP(s, name);
+    }
+    SDL_DestroySurface(s);
+
+    return ok;
+}
+
+
+
+static bool
+JobSelects(const Job * job, const WorkItem * item, const ViewResource * resource)
+{
+    return job->input_num == item->input_num
+        && (job->all_views || resource->number < 0
+            || (resource->number < MAX_RESOURCE_NUMBER && job->views[resource->number]));
+}
+
+
+
+static void
+RunWorkItem(int index, void * context)
+{
+    Plan * plan = context;
+    const WorkItem * item = &plan->items[index];
+    const ViewResource * resource = &plan->inputs[item->input_num].views[item->view_num];
+    BeginViewStats();
+
+    // With -update, only the outputs that are out of date are written, and
+    // the View isn't even decoded if none are.
+    bool stale[MAX_JOBS] = { false };
+    bool any_stale = false;
+    for ( int i = 0; i < plan->num_jobs; i++ ) {
+        const Job * job = &plan->jobs[i];
+        if ( JobSelects(job, item, resource) ) {
+            char name[512];
+            GetOutputName(job, resource, name, sizeof(name));
+            stale[i] = !IsUpToDate(name, &resource, 1);
+            any_stale |= stale[i];
+        }
+    }
+
+    View * view = any_stale ? SDL_malloc(sizeof(*view)) : NULL;
+    DecodedView decoded;
+
+    const char * error = NULL;
+    if ( any_stale && view == NULL ) {
+        error = SDL_GetError();
+    } else if ( any_stale && !ParseViewResource(view, resource) ) {
+        error = "not a valid View";
+    } else if ( any_stale && !DecodeView(&decoded, view) ) {
+        error = SDL_GetError();
+        ReleaseView(view);
+    }
+
+    if ( error ) {
+        PrintError("Error: '%s': %s\n", resource->name, error);
+        SDL_AddAtomicInt(&plan->num_errors, 1);
+        for ( int i = 0; i < plan->num_jobs; i++ ) {
+            if ( JobSelects(&plan->jobs[i], item, resource) ) {
+                CountProgress(resource->size, false);
+            }
+        }
+        SDL_free(view);
+        EndViewStats(resource->name);
+        return;
+    }
+
+    if ( any_stale ) {
+        SDL_AddAtomicInt(&plan->num_decoded, 1);
+    }
+
+    for ( int i = 0; i < plan->num_jobs; i++ ) {
+        const Job * job = &plan->jobs[i];
+        if ( !JobSelects(job, item, resource) ) {
+            continue;
+        }
+
+        char name[512];
+        GetOutputName(job, resource, name, sizeof(name));
+
+        bool ok = !stale[i] || WriteOutput(job, &decoded, name);
+        CountProgress(resource->size, ok);
+
+        if ( ok ) {
+            SDL_AddAtomicInt(stale[i] ? &plan->num_outputs : &plan->num_current, 1);
+            RecordDependencies(name, &resource, 1);
+        } else {
+            PrintError("Error: [%s] could not save '%s': %s\n", job->name, name, SDL_GetError());
+            SDL_AddAtomicInt(&plan->num_errors, 1);
+        }
+    }
+
+    if ( any_stale ) {
+        FreeDecodedView(&decoded);
+        ReleaseView(view);
+    }
+    SDL_free(view);
+    EndViewStats(resource->name);
+}
+
+
+
+/// Run every job in a job file, reporting progress and, if `metrics_path` is
+/// given, writing it as a Prometheus textfile. Returns false if any output
+/// failed.
+bool
+RunJobFile(const char * path, int num_threads, const char * metrics_path)
+{
+    Plan * plan = SDL_calloc(1, sizeof(*plan));
+    plan->jobs = SDL_calloc(MAX_JOBS, sizeof(Job));
+
+    bool ok = ReadJobFile(plan, path);
+    if ( ok ) {
+        MakePlan(plan);
+
+        int num_outputs = 0;
+        for ( int i = 0; i < plan->num_items; i++ ) {
+            const WorkItem * item = &plan->items[i];
+            const ViewResource * resource = &plan->inputs[item->input_num].views[item->view_num];
+            for ( int j = 0; j < plan->num_jobs; j++ ) {
+                num_outputs += JobSelects(&plan->jobs[j], item, resource);
+            }
+        }
+
+        StartProgress(num_outputs, metrics_path);
+        RunParallel(plan->num_items, num_threads, RunWorkItem, plan);
+        FinishProgress();
+
+        printf("%d jobs: %d Views decoded once each, %d outputs saved, %d up to date, %d errors\n",
+               plan->num_jobs,
+               SDL_GetAtomicInt(&plan->num_decoded),
+               SDL_GetAtomicInt(&plan->num_outputs),
+               SDL_GetAtomicInt(&plan->num_current),
+               SDL_GetAtomicInt(&plan->num_errors));
+        ok = SDL_GetAtomicInt(&plan->num_errors) == 0;
+    }
+
+    for ( int i = 0; i < plan->num_inputs; i++ ) {
+        FreeViewList(&plan->inputs[i]);
+    }
+
+    SDL_free(plan->items);
+    SDL_free(plan->jobs);
+    SDL_free(plan);
+
+    return ok;
+}
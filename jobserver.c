@@ -0,0 +1,189 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// GNU make jobserver client. When run from a recipe under `make -jN`, every
+// worker thread beyond the first must hold one of make's job tokens while it
+// works, so all of make's jobs together use at most N cores. Tokens are bytes
+// read from (and written back to) a pipe or FIFO named in MAKEFLAGS.
+//
+// Note that make only passes a pipe jobserver to recipes that it knows run
+// make-aware commands (prefixed with '+'); otherwise the descriptors are
+// closed and the jobserver is ignored.
+//
+
+#include "agi.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// How often a worker waiting for a token checks whether any work is left.
+#define POLL_MS 50
+
+static int read_fd = -1;
+static int write_fd = -1;
+
+
+
+/// Make token reads non-blocking, so a worker that loses a token to another
+/// process between poll and read goes back to polling. The pipe is opened
+/// again where the platform allows, so that make's own descriptor is left
+/// blocking.
+static bool
+SetReadNonBlocking(void)
+{
+    char path[32];
+    snprintf(path, sizeof(path), "/dev/fd/%d", read_fd);
+    int fd = open(path, O_RDONLY | O_NONBLOCK);
+    if ( fd != -1 ) {
+        read_fd = fd;
+    }
+
+    int flags = fcntl(read_fd, F_GETFL);
+    return flags != -1 && fcntl(read_fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+
+
+/// Connect to make's jobserver if MAKEFLAGS names one. Returns true if
+/// connected.
+bool
+JobserverInit(void)
+{
+#ifdef _WIN32
+    return false;
+#else
+    const char * flags = SDL_getenv("MAKEFLAGS");
+    if ( flags == NULL ) {
+        return false;
+    }
+
+    // The last --jobserver-auth wins; --jobserver-fds is the pre-4.2 name.
+    const char * auth = NULL;
+    for ( const char * p = flags; (p = strstr(p, "--jobserver-")) != NULL; p++ ) {
+        if ( strncmp(p, "--jobserver-auth=", 17) == 0 ) {
+            auth = p + 17;
+        } else if ( strncmp(p, "--jobserver-fds=", 16) == 0 ) {
+            auth = p + 16;
+        }
+    }
+
+    if ( auth == NULL ) {
+        return false;
+    }
+
+    if ( strncmp(auth, "fifo:", 5) == 0 ) {
+        char path[512];
+        size_t length = strcspn(auth + 5, " ");
+        snprintf(path, sizeof(path), "%.*s", (int)SDL_min(length, sizeof(path) - 1), auth + 5);
+
+        write_fd = open(path, O_RDWR);
+        read_fd = open(path, O_RDONLY | O_NONBLOCK);
+        if ( read_fd == -1 || write_fd == -1 ) {
+            fprintf(stderr, "Warning: could not open jobserver FIFO '%s': %s\n",
+                    path, strerror(errno));
+            if ( read_fd != -1 ) {
+                close(read_fd);
+            }
+            if ( write_fd != -1 ) {
+                close(write_fd);
+            }
+            read_fd = write_fd = -1;
+            return false;
+        }
+    } else if ( sscanf(auth, "%d,%d", &read_fd, &write_fd) != 2
+               || fcntl(read_fd, F_GETFD) == -1
+               || fcntl(write_fd, F_GETFD) == -1 ) {
+        fprintf(stderr, "Warning: jobserver unavailable (prefix the recipe "
+                "with '+'), not limiting threads\n");
+        read_fd = write_fd = -1;
+        return false;
+    } else if ( !SetReadNonBlocking() ) {
+        fprintf(stderr, "Warning: jobserver unusable (%s), not limiting threads\n",
+                strerror(errno));
+        read_fd = write_fd = -1;
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+
+
+bool
+JobserverActive(void)
+{
+    return read_fd != -1;
+}
+
+
+
+/// Wait for a job token. Gives up and returns false once `done` returns true,
+/// so workers don't wait for tokens when there is nothing left to do.
+bool
+JobserverAcquire(Uint8 * token, bool (* done)(void * context), void * context)
+{
+#ifdef _WIN32
+    return false;
+#else
+    while ( !done(context) ) {
+        struct pollfd pfd = { .fd = read_fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, POLL_MS);
+
+        if ( ready < 0 && errno != EINTR ) {
+            return false;
+        }
+
+        // Another process may take the token between poll and read, in which
+        // case the read fails with EAGAIN and this goes back to polling.
+        if ( ready > 0 ) {
+            ssize_t n = read(read_fd, token, 1);
+            if ( n == 1 ) {
+                return true;
+            } else if ( n == 0
+                       || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) ) {
+                return false;
+            }
+        }
+    }
+
+    return false;
+#endif
+}
+
+
+
+/// Return a token to the jobserver.
+void
+JobserverRelease(Uint8 token)
+{
+#ifndef _WIN32
+    while ( write(write_fd, &token, 1) == -1 && errno == EINTR ) { }
+#endif
+}
@@ -27,241 +27,288 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "agi.h"
+
 #define VER_MAJ 1
 #define VER_MIN 0
 
-#define MAX_LOOPS 255
-#define MAX_CELS 255
-
-const SDL_Color pal[16] = {
-    { 0x00, 0x00, 0x00, 0xFF },
-    { 0x00, 0x00, 0xAA, 0xFF },
-    { 0x00, 0xAA, 0x00, 0xFF },
-    { 0x00, 0xAA, 0xAA, 0xFF },
-    { 0xAA, 0x00, 0x00, 0xFF },
-    { 0xAA, 0x00, 0xAA, 0xFF },
-    { 0xAA, 0x55, 0x00, 0xFF },
-    { 0xAA, 0xAA, 0xAA, 0xFF },
-    { 0x55, 0x55, 0x55, 0xFF },
-    { 0x55, 0x55, 0xFF, 0xFF },
-    { 0x55, 0xFF, 0x55, 0xFF },
-    { 0x55, 0xFF, 0xFF, 0xFF },
-    { 0xFF, 0x55, 0x55, 0xFF },
-    { 0xFF, 0x55, 0xFF, 0xFF },
-    { 0xFF, 0xFF, 0x55, 0xFF },
-    { 0xFF, 0xFF, 0xFF, 0xFF }
-};
-
+static const char * image_extension = "bmp";
+static int pic_steps = 0;           // Save a frame every n picture commands.
+static bool pic_priority = false;   // Save pictures' priority screens.
 
 
-typedef struct {
-    Uint16 header_offset;
-    Uint16 data_offset;
-    Uint8 width;
-    Uint8 height;
-    Uint8 transparency_color;
-    Uint8 is_mirrored;
-    Uint8 unmirrored_loop_num;
-} Cel;
 
+/// Convert a View to an image. Success is only reported when no progress
+/// reporter is running; errors always are.
+bool
+ViewToBMP(const ViewResource * resource)
+{
+    char name[512] = { 0 };
+    snprintf(name, sizeof(name), "%s.%s", resource->name, image_extension);
 
+    if ( IsUpToDate(name, &resource, 1) ) {
+        if ( !ProgressActive() ) {
+            printf("Converting %s... %s is up to date\n", resource->name, name);
+        }
+        RecordDependencies(name, &resource, 1);
+        return true;
+    }
 
-typedef struct {
-    Uint16 offset;
-    Uint8 num_cels;
-    Uint8 total_width;
-    Uint8 total_height;
-    Cel cels[MAX_CELS];
-} Loop;
+    View * view = SDL_malloc(sizeof(*view));
+    if ( view == NULL ) {
+        PrintError("Converting %s... Error: %s\n", resource->name, SDL_GetError());
+        return false;
+    }
+    if ( !ParseViewResource(view, resource) ) {
+        PrintError("Converting %s... Error: not a valid View\n", resource->name);
+        SDL_free(view);
+        return false;
+    }
 
+    SDL_Surface * s = RenderView(view);
+    ReleaseView(view);
+    SDL_free(view);
+    if ( s == NULL ) {
+        PrintError("Converting %s... Error: %s\n", resource->name, SDL_GetError());
+        return false;
+    }
 
+    CountSurface(s);
+    bool saved = SaveImage(s, name, 1); // Views are converted in parallel already.
+    if ( !saved ) {
+        PrintError("Converting %s... Error: could not save '%s': %s\n",
+                   resource->name, name, SDL_GetError());
+    } else {
+        if ( !ProgressActive() ) {
+            printf("Converting %s... saved %s\n", resource->name, name);
+        }
+        RecordDependencies(name, &resource, 1);
+    }
+    SDL_DestroySurface(s);
 
-typedef struct {
-    Loop loops[MAX_LOOPS];
-    Uint8 num_loops;
-} View;
+    return saved;
+}
 
 
 
-/// Calculate the surface size needed to accommodate all loops and cells in a
-/// View. Also updates the each loop's size.
-SDL_Rect
-GetSurfaceSize(View * view)
+/// Save a View as a delta-encoded loop animation file (.agd).
+bool
+ViewToDelta(const ViewResource * resource)
 {
-    SDL_Rect result = { 0 };
+    char name[512] = { 0 };
+    snprintf(name, sizeof(name), "%s.agd", resource->name);
+
+    if ( IsUpToDate(name, &resource, 1) ) {
+        if ( !ProgressActive() ) {
+            printf("Converting %s... %s is up to date\n", resource->name, name);
+        }
+        RecordDependencies(name, &resource, 1);
+        return true;
+    }
 
-    for ( int i = 0; i < view->num_loops; i++ ) {
-        Loop * loop = &view->loops[i];
+    View * view = SDL_malloc(sizeof(*view));
+    if ( view == NULL ) {
+        PrintError("Converting %s... Error: %s\n", resource->name, SDL_GetError());
+        return false;
+    }
+    if ( !ParseViewResource(view, resource) ) {
+        PrintError("Converting %s... Error: not a valid View\n", resource->name);
+        SDL_free(view);
+        return false;
+    }
 
-        for ( int j = 0; j < loop->num_cels; j++ ) {
-            Cel * cel = &loop->cels[j];
+    // The decoded cels are all that's needed of the resource.
+    DecodedView decoded;
+    bool ok = DecodeView(&decoded, view);
+    ReleaseView(view);
+    if ( !ok ) {
+        PrintError("Converting %s... Error: %s\n", resource->name, SDL_GetError());
+        SDL_free(view);
+        return false;
+    }
 
-            loop->total_width += loop->cels[j].width;
-            if ( cel->height > loop->total_height ) {
-                loop->total_height = cel->height;
-            }
-        }
+    size_t size;
+    Uint8 * data = EncodeDelta(&decoded, &size);
+    FreeDecodedView(&decoded);
 
-        if ( loop->total_width > result.w ) {
-            result.w = loop->total_width;
+    bool saved = SDL_SaveFile(name, data, size);
+    if ( saved ) {
+        if ( !ProgressActive() ) {
+            printf("Converting %s... saved %s (%zu bytes)\n", resource->name, name, size);
         }
-
-        result.h += loop->total_height;
+        RecordDependencies(name, &resource, 1);
+    } else {
+        PrintError("Converting %s... Error: could not save '%s': %s\n",
+                   resource->name, name, SDL_GetError());
     }
 
-    result.w *= 2; // Accommodate double-wide pixels.
+    SDL_free(data);
+    SDL_free(view);
 
-    return result;
+    return saved;
 }
 
 
 
-SDL_Surface *
-CreateSurface(View * view)
+/// Draw a picture and save it, or with -steps, every frame of its drawing.
+bool
+PictureToImage(const ViewResource * resource)
 {
-    SDL_Rect size = GetSurfaceSize(view);
+    char name[512] = { 0 };
+    snprintf(name, sizeof(name), "%s.%s", resource->name, image_extension);
 
-    SDL_Surface * s = SDL_CreateSurface(size.w, size.h, SDL_PIXELFORMAT_RGBA32);
-    if ( s == NULL ) {
-        fprintf(stderr, "SDL_CreateSurface failed: %s\n", SDL_GetError());
-        exit(EXIT_FAILURE);
+    if ( pic_steps <= 0 && IsUpToDate(name, &resource, 1) ) {
+        if ( !ProgressActive() ) {
+            printf("Drawing %s... %s is up to date\n", resource->name, name);
+        }
+        RecordDependencies(name, &resource, 1);
+        return true;
     }
 
-    // Clear the surface
-    const SDL_PixelFormatDetails * details = SDL_GetPixelFormatDetails(s->format);
-    Uint32 blank = SDL_MapRGBA(details, NULL, 0, 0, 0, 0);
-    SDL_FillSurfaceRect(s, NULL, blank);
+    Source source;
+    PicDrawing drawing;
+    bool ok = LoadResource(resource, &source);
+    if ( ok ) {
+        ok = DrawPicture(&drawing, source.data, source.size, pic_steps);
+        CloseSource(&source);
+    }
 
-    return s;
-}
+    if ( !ok ) {
+        PrintError("Drawing %s... Error: %s\n", resource->name, SDL_GetError());
+        return false;
+    }
 
+    bool saved = true;
+    for ( int i = 0; i < drawing.num_frames && saved; i++ ) {
+        if ( pic_steps > 0 ) {
+            snprintf(name, sizeof(name), "%s.%04d.%s", resource->name, i, image_extension);
+        }
 
+        SDL_Surface * s = RenderPicFrame(&drawing.frames[i], pic_priority);
+        saved = s && SaveImage(s, name, 1);
+        if ( saved ) {
+            RecordDependencies(name, &resource, 1);
+        } else {
+            PrintError("Drawing %s... Error: could not save '%s': %s\n",
+                       resource->name, name, SDL_GetError());
+        }
+        SDL_DestroySurface(s);
+    }
 
-void
-ViewToBMP(const char * path)
-{
-    printf("Converting %s... ", path);
-    FILE * file = fopen(path, "rb");
-    if ( file == NULL ) {
-        printf("Error: could not open view file '%s': %s\n", path, strerror(errno));
-        return;
+    if ( saved && !ProgressActive() ) {
+        if ( pic_steps > 0 ) {
+            printf("Drawing %s... saved %d frames (%d rows copied)\n",
+                   resource->name, drawing.num_frames, drawing.rows_copied);
+        } else {
+            printf("Drawing %s... saved %s\n", resource->name, name);
+        }
     }
 
-    View view = { 0 };
+    FreePicDrawing(&drawing);
+
+    return saved;
+}
+
 
-    // Read the number of loops.
-    fseek(file, 2, SEEK_SET);
-    fread(&view.num_loops, sizeof(Uint8), 1, file);
 
-    // Seek to start of loop offset list.
-    fseek(file, 5, SEEK_SET);
+/// Views or Pictures that could not be converted, counted by the workers so
+/// that `main` can fail.
+static SDL_AtomicInt num_failed;
 
-    // Read all loop offsets.
-    for ( int i = 0; i < view.num_loops; i++ ) {
-        fread(&view.loops[i].offset, sizeof(Uint16), 1, file);
+
+
+static void
+ConvertWork(int index, void * context)
+{
+    const ViewList * list = context;
+    BeginViewStats();
+    bool ok = ViewToBMP(&list->views[index]);
+    EndViewStats(list->views[index].name);
+    CountProgress(list->views[index].size, ok);
+    if ( !ok ) {
+        SDL_AddAtomicInt(&num_failed, 1);
     }
+}
 
-    // Read all loops.
-    for ( int i = 0; i < view.num_loops; i++ ) {
-        Loop * loop = &view.loops[i];
-        fseek(file, loop->offset, SEEK_SET);
 
-        // Read the number of cels in this loop.
-        fread(&loop->num_cels, sizeof(Uint8), 1, file);
 
-        // Read the cel header offsets, storing them as absolute offsets.
-        for ( int j = 0; j < loop->num_cels; j++ ) {
-            Uint16 rel_offset;
-            fread(&rel_offset, sizeof(Uint16), 1, file);
-            loop->cels[j].header_offset = loop->offset + rel_offset;
-        }
+static void
+DeltaWork(int index, void * context)
+{
+    const ViewList * list = context;
+    BeginViewStats();
+    bool ok = ViewToDelta(&list->views[index]);
+    EndViewStats(list->views[index].name);
+    CountProgress(list->views[index].size, ok);
+    if ( !ok ) {
+        SDL_AddAtomicInt(&num_failed, 1);
+    }
+}
 
-        // Read each cel header and store info.
-        for ( int j = 0; j < loop->num_cels; j++ ) {
-            Cel * cel = &loop->cels[j];
-            fseek(file, loop->cels[j].header_offset, SEEK_SET);
 
-            Uint8 info;
-            fread(&cel->width, sizeof(Uint8), 1, file);
-            fread(&cel->height, sizeof(Uint8), 1, file);
-            fread(&info, sizeof(Uint8), 1, file);
 
-            cel->is_mirrored = (info & 0x80) >> 7;
-            cel->unmirrored_loop_num = (info & 0x70) >> 4;
-            cel->transparency_color = (info & 0x0F);
-            cel->data_offset = ftell(file);
-        }
+static void
+PictureWork(int index, void * context)
+{
+    const ViewList * list = context;
+    BeginViewStats();
+    bool ok = PictureToImage(&list->views[index]);
+    EndViewStats(list->views[index].name);
+    CountProgress(list->views[index].size, ok);
+    if ( !ok ) {
+        SDL_AddAtomicInt(&num_failed, 1);
     }
+}
 
-    SDL_Surface * s = CreateSurface(&view);
-
-    // Write each loop's cels horizontally from left to right, each loop in its
-    // own row.
-    int cel_y = 0;
-    for ( int i = 0; i < view.num_loops; i++ ) {
-        Loop * loop = &view.loops[i];
-
-        int cel_x = 0;
-        for ( int j = 0; j < loop->num_cels; j++ ) {
-            Cel * cel = &loop->cels[j];
-            fseek(file, cel->data_offset, SEEK_SET);
-
-            for ( int y = cel_y; y < cel_y + cel->height; y++ ) {
-                int x;
-                int step;
-                if ( cel->is_mirrored && cel->unmirrored_loop_num != i ) {
-                    x = cel_x + (cel->width * 2) - 1;
-                    step = -1;
-                } else {
-                    x = cel_x;
-                    step = 1;
-                }
-
-                while ( 1 ) {
-                    // Read image data.
-                    Uint8 byte;
-                    fread(&byte, sizeof(byte), 1, file);
-
-                    if ( byte == 0 ) {
-                        break; // End of this row.
-                    }
-
-                    Uint8 color = (byte >> 4) & 0x0F;
-                    Uint8 count = byte & 0x0F;
-
-                    // Decompress RLE data and write to surface.
-                    while ( count-- ) {
-                        Uint8 r = 0, g = 0, b = 0, a = 0;
-
-                        if ( color != cel->transparency_color ) {
-                            r = pal[color].r;
-                            g = pal[color].g;
-                            b = pal[color].b;
-                            a = 255;
-                        }
-
-                        // Write doubled pixel.
-                        for ( int k = 0; k < 2; k++ ) {
-                            SDL_WriteSurfacePixel(s, x, y, r, g, b, a);
-                            x += step;
-                        }
-                    }
-                }
-            }
 
-            cel_x += cel->width * 2; // Accommodate double-wide pixels
-        }
 
-        cel_y += loop->total_height;
+static void
+ScanWork(const ViewResource * view, void * context)
+{
+    const bool * delta = context;
+    BeginViewStats();
+    bool ok = *delta ? ViewToDelta(view) : ViewToBMP(view);
+    EndViewStats(view->name);
+    if ( !ok ) {
+        SDL_AddAtomicInt(&num_failed, 1);
     }
+}
+
 
-    char name[256] = { 0 };
-    snprintf(name, sizeof(name), "%s.bmp", path);
-    SDL_SaveBMP(s, name);
-    printf("saved %s\n", name);
-    SDL_DestroySurface(s);
 
-    fclose(file);
+static void
+PrintUsage(const char * program)
+{
+    printf("usage: %s [view path(, view path, ...)]\n", program);
+    printf("       %s -sheet [-loop n] [-cel n] [-shrink n] [-columns n] "
+           "[-o file] [view path, ...]\n", program);
+    printf("       %s -diff [-images] [-o directory] old_path new_path\n", program);
+    printf("       %s -delta [view path, ...]\n", program);
+    printf("       %s -undelta [agd path, ...]\n", program);
+    printf("       %s -scan [-delta] [VOL path or -, ...]\n", program);
+    printf("       %s -csource [-o name] [view path, ...]\n", program);
+    printf("       %s -pic [-steps n] [-priority] [picture path, ...]\n", program);
+    printf("       %s -jobs job_file\n", program);
+    printf("       %s -bench [-repeat n] [view path, ...]\n", program);
+    printf("       %s -view [-frames n] [-cache mb] [view path, ...]\n", program);
+    printf("       %s -profile [-o profile_file] [view path, ...]\n", program);
+    printf("       %s -synth profile_file [-count n] [-seed n] -o directory\n", program);
+    printf("\nOptions for all modes:\n");
+    printf("  -j threads                  Worker threads (default: one per core)\n");
+    printf("  -kernel auto|scalar|prefix  RLE decoder to use (default: auto)\n");
+    printf("  -png                        Save PNG instead of BMP\n");
+    printf("  -dds, -ktx2                 Save DDS or KTX2 textures with mipmaps\n");
+    printf("  -bounded                    Fail cels with truncated or overlong data\n");
+    printf("  -timeout ms                 Give up on any View taking longer than ms\n");
+    printf("  -metrics file               Also write progress as a Prometheus textfile\n");
+    printf("  -stats                      Report allocations and peak memory\n");
+    printf("  -MD                         Write a dependency file next to each output\n");
+    printf("  -MF file                    Write all outputs' dependencies to file\n");
+    printf("  -update                     Skip outputs newer than all their inputs\n");
+    printf("\nA view path may be a View file, a game directory containing "
+           "VIEWDIR (AGI v2), a combined directory such as KQ4DIR (AGI v3) or "
+           "RESOURCE.MAP (SCI0), or a FAT12/FAT16 disk image. Picture paths are "
+           "the same, with PICDIR in place of VIEWDIR.\n");
 }
 
 
@@ -276,12 +323,250 @@ main(int argc, char ** argv)
            VER_MAJ, VER_MIN);
 
     if ( argc < 2 ) {
-        printf("usage: %s [view path(, view path, ...)]\n", argv[0]);
+        PrintUsage(argv[0]);
+    }
+
+    // Allocation counting has to start before anything is allocated.
+    for ( int i = 1; i < argc; i++ ) {
+        if ( strcmp(argv[i], "-stats") == 0 && !EnableStats() ) {
+            return EXIT_FAILURE;
+        }
     }
 
+    bool sheet = false;
+    bool diff = false;
+    bool delta = false;
+    bool undelta = false;
+    bool scan = false;
+    bool pic = false;
+    bool csource = false;
+    const char * job_file = NULL;
+    bool bench = false;
+    int repeat = 100;
+    bool viewer = false;
+    bool profile = false;
+    const char * synth_profile = NULL;
+    int count = 100;
+    Uint64 seed = 0;
+    const char * output = NULL;
+    int num_threads = 0;
+    bool per_output_deps = false;
+    const char * deps_path = NULL;
+    const char * metrics_path = NULL;
+    bool update = false;
+    SheetOptions sheet_options = { .shrink = 2 };
+    DiffOptions diff_options = { 0 };
+    ViewerOptions viewer_options = { .cache_bytes = 64 << 20 };
+    const char ** paths = SDL_calloc(argc, sizeof(char *));
+    int num_paths = 0;
+
     for ( int i = 1; i < argc; i++ ) {
-        ViewToBMP(argv[i]);
+        const char * arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if ( strcmp(arg, "-sheet") == 0 ) {
+            sheet = true;
+        } else if ( strcmp(arg, "-diff") == 0 ) {
+            diff = true;
+        } else if ( strcmp(arg, "-delta") == 0 ) {
+            delta = true;
+        } else if ( strcmp(arg, "-undelta") == 0 ) {
+            undelta = true;
+        } else if ( strcmp(arg, "-scan") == 0 ) {
+            scan = true;
+        } else if ( strcmp(arg, "-csource") == 0 ) {
+            csource = true;
+        } else if ( strcmp(arg, "-pic") == 0 ) {
+            pic = true;
+        } else if ( strcmp(arg, "-steps") == 0 && has_value ) {
+            pic_steps = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-priority") == 0 ) {
+            pic_priority = true;
+        } else if ( strcmp(arg, "-jobs") == 0 && has_value ) {
+            job_file = argv[++i];
+        } else if ( strcmp(arg, "-bench") == 0 ) {
+            bench = true;
+        } else if ( strcmp(arg, "-profile") == 0 ) {
+            profile = true;
+        } else if ( strcmp(arg, "-synth") == 0 && has_value ) {
+            synth_profile = argv[++i];
+        } else if ( strcmp(arg, "-count") == 0 && has_value ) {
+            count = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-seed") == 0 && has_value ) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if ( strcmp(arg, "-repeat") == 0 && has_value ) {
+            repeat = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-view") == 0 ) {
+            viewer = true;
+        } else if ( strcmp(arg, "-frames") == 0 && has_value ) {
+            viewer_options.frames = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-cache") == 0 && has_value ) {
+            int mb = atoi(argv[++i]);
+            viewer_options.cache_bytes = (size_t)SDL_max(mb, 1) << 20;
+        } else if ( strcmp(arg, "-kernel") == 0 && has_value ) {
+            const char * name = argv[++i];
+            if ( strcmp(name, "scalar") == 0 ) {
+                decode_kernel = KERNEL_SCALAR;
+            } else if ( strcmp(name, "prefix") == 0 ) {
+                decode_kernel = KERNEL_PREFIX;
+            } else {
+                decode_kernel = KERNEL_AUTO;
+            }
+        } else if ( strcmp(arg, "-png") == 0 ) {
+            image_extension = "png";
+        } else if ( strcmp(arg, "-dds") == 0 ) {
+            image_extension = "dds";
+        } else if ( strcmp(arg, "-ktx2") == 0 ) {
+            image_extension = "ktx2";
+        } else if ( strcmp(arg, "-bounded") == 0 ) {
+            decode_bounded = true;
+        } else if ( strcmp(arg, "-timeout") == 0 && has_value ) {
+            decode_timeout_ns = SDL_MS_TO_NS((Uint64)atoi(argv[++i]));
+        } else if ( strcmp(arg, "-images") == 0 ) {
+            diff_options.images = true;
+        } else if ( strcmp(arg, "-metrics") == 0 && has_value ) {
+            metrics_path = argv[++i];
+        } else if ( strcmp(arg, "-stats") == 0 ) {
+            // Handled above.
+        } else if ( strcmp(arg, "-MD") == 0 ) {
+            per_output_deps = true;
+        } else if ( strcmp(arg, "-MF") == 0 && has_value ) {
+            deps_path = argv[++i];
+        } else if ( strcmp(arg, "-update") == 0 ) {
+            update = true;
+        } else if ( strcmp(arg, "-j") == 0 && has_value ) {
+            num_threads = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-loop") == 0 && has_value ) {
+            sheet_options.loop = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-cel") == 0 && has_value ) {
+            sheet_options.cel = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-shrink") == 0 && has_value ) {
+            sheet_options.shrink = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-columns") == 0 && has_value ) {
+            sheet_options.columns = atoi(argv[++i]);
+        } else if ( strcmp(arg, "-o") == 0 && has_value ) {
+            output = argv[++i];
+        } else if ( arg[0] == '-' && arg[1] != '\0' ) {
+            printf("Error: unknown option '%s'\n", arg);
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            paths[num_paths++] = arg;
+        }
+    }
+
+    JobserverInit();
+    InitDependencies(per_output_deps, deps_path, update);
+
+    if ( diff ) {
+        if ( num_paths != 2 ) {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        diff_options.directory = output;
+        diff_options.extension = image_extension;
+        diff_options.num_threads = num_threads;
+        int result = DiffGames(paths[0], paths[1], &diff_options);
+        CloseSourceCache();
+        SDL_free(paths);
+
+        return result < 0 ? EXIT_FAILURE : 0;
+    }
+
+    if ( job_file ) {
+        bool ok = RunJobFile(job_file, num_threads, metrics_path);
+        CloseSourceCache();
+        ok &= FinishDependencies();
+        PrintStats();
+        SDL_free(paths);
+
+        return ok ? 0 : EXIT_FAILURE;
     }
 
-    return 0;
+    if ( synth_profile ) {
+        bool ok = output && SynthesizeGame(synth_profile, output, count, seed);
+        if ( output == NULL ) {
+            PrintUsage(argv[0]);
+        }
+        SDL_free(paths);
+
+        return ok ? 0 : EXIT_FAILURE;
+    }
+
+    if ( undelta ) {
+        bool ok = true;
+        for ( int i = 0; i < num_paths; i++ ) {
+            ok &= DeltaToBMP(paths[i]);
+        }
+        SDL_free(paths);
+
+        return ok ? 0 : EXIT_FAILURE;
+    }
+
+    if ( scan ) {
+        bool ok = true;
+        for ( int i = 0; i < num_paths; i++ ) {
+            ok &= ScanVolume(paths[i], ScanWork, &delta);
+        }
+        ok &= SDL_GetAtomicInt(&num_failed) == 0;
+        ok &= FinishDependencies();
+        PrintStats();
+        SDL_free(paths);
+
+        return ok ? 0 : EXIT_FAILURE;
+    }
+
+    ViewList list = { 0 };
+    bool ok = true;
+    for ( int i = 0; i < num_paths; i++ ) {
+        ok &= CollectResources(&list, paths[i], pic ? RESOURCE_PICTURE : RESOURCE_VIEW);
+    }
+
+    if ( pic ) {
+        if ( list.num_views > 1 || metrics_path ) {
+            StartProgress(list.num_views, metrics_path);
+        }
+
+        RunParallel(list.num_views, num_threads, PictureWork, &list);
+        FinishProgress();
+    } else if ( csource ) {
+        if ( list.num_views > 0 ) {
+            ok &= ExportCSource(&list, output ? output : "views");
+        }
+    } else if ( profile ) {
+        ok &= ProfileViews(&list, output);
+    } else if ( bench ) {
+        ok &= RunBenchmark(&list, repeat);
+    } else if ( viewer ) {
+        ok &= RunViewer(&list, &viewer_options);
+    } else if ( sheet ) {
+        sheet_options.output = output;
+        sheet_options.num_threads = num_threads;
+        char sheet_name[16];
+        if ( output == NULL && strcmp(image_extension, "bmp") != 0 ) {
+            snprintf(sheet_name, sizeof(sheet_name), "sheet.%s", image_extension);
+            sheet_options.output = sheet_name;
+        }
+        if ( list.num_views > 0 ) {
+            ok &= MakeContactSheet(&list, &sheet_options);
+        }
+    } else {
+        // In batch mode, report overall progress instead of every View.
+        if ( list.num_views > 1 || metrics_path ) {
+            StartProgress(list.num_views, metrics_path);
+        }
+
+        RunParallel(list.num_views, num_threads, delta ? DeltaWork : ConvertWork, &list);
+        FinishProgress();
+    }
+
+    ok &= SDL_GetAtomicInt(&num_failed) == 0;
+    ok &= FinishDependencies();
+    FreeViewList(&list);
+    CloseSourceCache();
+    PrintStats();
+    SDL_free(paths);
+
+    return ok ? 0 : EXIT_FAILURE;
 }
@@ -0,0 +1,566 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+// AGI picture resources: a list of drawing commands for a 160x168 visual
+// screen and a priority screen of the same size. Each command is a byte of
+// 0xF0 or above followed by operands below 0xF0.
+//
+// Drawing can be recorded as a sequence of frames, one after every few
+// commands. The canvas is a set of rows shared with the frames: taking a frame
+// only copies the row pointers, and a row is copied when it is next drawn on,
+// so each frame costs only the rows drawn since the last one.
+
+#include "agi.h"
+
+#define VISUAL_BACKGROUND 15   // The visual screen starts white,
+#define PRIORITY_BACKGROUND 4  // and the priority screen red.
+
+
+
+struct PicRow {
+    int references; // Frames and canvas sharing this row.
+    Uint8 visual[PIC_WIDTH];
+    Uint8 priority[PIC_WIDTH];
+};
+
+
+
+typedef struct {
+    const Uint8 * data;
+    size_t size;
+    size_t pos;
+
+    PicRow * rows[PIC_HEIGHT];
+    bool visual_on;
+    bool priority_on;
+    Uint8 visual_color;
+    Uint8 priority_color;
+    Uint8 pen;          // Bits 0-2: size, 0x10: rectangle, 0x20: spray.
+    Uint8 texture;      // Spray pattern for the next plot.
+
+    PicDrawing * drawing;
+} Picture;
+
+
+
+/// Get the next operand, or -1 at the next command, which is left unread.
+static int
+NextOperand(Picture * pic)
+{
+    if ( pic->pos >= pic->size || pic->data[pic->pos] >= 0xF0 ) {
+        return -1;
+    }
+
+    return pic->data[pic->pos++];
+}
+
+
+
+/// Get a row for drawing, first copying it if it is shared with a frame.
+static PicRow *
+WritableRow(Picture * pic, int y)
+{
+    PicRow * row = pic->rows[y];
+    if ( row->references == 1 ) {
+        return row;
+    }
+
+    PicRow * copy = SDL_malloc(sizeof(*copy));
+    if ( copy == NULL ) {
+        return NULL;
+    }
+
+    memcpy(copy, row, sizeof(*copy));
+    copy->references = 1;
+    row->references--;
+    pic->rows[y] = copy;
+    pic->drawing->rows_copied++;
+
+    return copy;
+}
+
+
+
+static void
+Plot(Picture * pic, int x, int y)
+{
+    if ( x < 0 || x >= PIC_WIDTH || y < 0 || y >= PIC_HEIGHT ) {
+        return;
+    }
+
+    PicRow * row = WritableRow(pic, y);
+    if ( row == NULL ) {
+        return;
+    }
+
+    if ( pic->visual_on ) {
+        row->visual[x] = pic->visual_color;
+    }
+
+    if ( pic->priority_on ) {
+        row->priority[x] = pic->priority_color;
+    }
+}
+
+
+
+/// Draw a line the way the interpreter does, stepping along the longer axis.
+static void
+DrawLine(Picture * pic, int x1, int y1, int x2, int y2)
+{
+    x1 = SDL_min(x1, PIC_WIDTH - 1);
+    x2 = SDL_min(x2, PIC_WIDTH - 1);
+    y1 = SDL_min(y1, PIC_HEIGHT - 1);
+    y2 = SDL_min(y2, PIC_HEIGHT - 1);
+
+    int step_x = x2 < x1 ? -1 : 1;
+    int step_y = y2 < y1 ? -1 : 1;
+    int delta_x = SDL_abs(x2 - x1);
+    int delta_y = SDL_abs(y2 - y1);
+
+    int count, error_x, error_y, detdelta;
+    if ( delta_y > delta_x ) {
+        count = delta_y;
+        detdelta = delta_y;
+        error_x = delta_y / 2;
+        error_y = 0;
+    } else {
+        count = delta_x;
+        detdelta = delta_x;
+        error_x = 0;
+        error_y = delta_x / 2;
+    }
+
+    int x = x1;
+    int y = y1;
+    Plot(pic, x, y);
+
+    for ( ; count > 0; count-- ) {
+        error_y += delta_y;
+        if ( error_y >= detdelta ) {
+            error_y -= detdelta;
+            y += step_y;
+        }
+
+        error_x += delta_x;
+        if ( error_x >= detdelta ) {
+            error_x -= detdelta;
+            x += step_x;
+        }
+
+        Plot(pic, x, y);
+    }
+}
+
+
+
+/// Whether a flood fill may color a pixel: one still the background color of
+/// the screen being drawn on, and not already the color being drawn.
+static bool
+CanFill(const Picture * pic, int x, int y)
+{
+    const PicRow * row = pic->rows[y];
+
+    if ( pic->visual_on ) {
+        return pic->visual_color != VISUAL_BACKGROUND
+            && row->visual[x] == VISUAL_BACKGROUND;
+    }
+
+    if ( pic->priority_on ) {
+        return pic->priority_color != PRIORITY_BACKGROUND
+            && row->priority[x] == PRIORITY_BACKGROUND;
+    }
+
+    return false;
+}
+
+
+
+/// Flood fill from (x, y), a span at a time.
+static void
+Fill(Picture * pic, int x, int y)
+{
+    if ( x >= PIC_WIDTH || y >= PIC_HEIGHT || !CanFill(pic, x, y) ) {
+        return;
+    }
+
+    typedef struct { Uint8 x, y; } Seed;
+    int capacity = 256;
+    int count = 0;
+    Seed * seeds = SDL_malloc(capacity * sizeof(*seeds));
+    if ( seeds == NULL ) {
+        return;
+    }
+    seeds[count++] = (Seed){ x, y };
+
+    while ( count > 0 ) {
+        Seed seed = seeds[--count];
+        if ( !CanFill(pic, seed.x, seed.y) ) {
+            continue;
+        }
+
+        int left = seed.x;
+        int right = seed.x;
+        while ( left > 0 && CanFill(pic, left - 1, seed.y) ) {
+            left--;
+        }
+        while ( right < PIC_WIDTH - 1 && CanFill(pic, right + 1, seed.y) ) {
+            right++;
+        }
+
+        for ( int i = left; i <= right; i++ ) {
+            Plot(pic, i, seed.y);
+        }
+
+        // Seed each span of fillable pixels above and below.
+        for ( int dy = -1; dy <= 1; dy += 2 ) {
+            int ny = seed.y + dy;
+            if ( ny < 0 || ny >= PIC_HEIGHT ) {
+                continue;
+            }
+
+            for ( int i = left; i <= right; i++ ) {
+                if ( !CanFill(pic, i, ny) || (i > left && CanFill(pic, i - 1, ny)) ) {
+                    continue;
+                }
+
+                if ( count == capacity ) {
+                    capacity *= 2;
+                    Seed * grown = SDL_realloc(seeds, capacity * sizeof(*seeds));
+                    if ( grown == NULL ) {
+                        SDL_free(seeds);
+                        return;
+                    }
+                    seeds = grown;
+                }
+                seeds[count++] = (Seed){ i, ny };
+            }
+        }
+    }
+
+    SDL_free(seeds);
+}
+
+
+
+/// Plot the pen at (x, y): a circle or rectangle, solid or sprayed with a
+/// pseudo-random pattern. Pen shapes are defined at double horizontal
+/// resolution, one row per word, and sampled at every other bit.
+static void
+PlotPen(Picture * pic, int x, int y)
+{
+    static const Uint8 circle_offsets[8] = { 0, 1, 4, 9, 16, 25, 37, 50 };
+    static const Uint16 circles[] = {
+        0x8000,
+        0xE000, 0xE000, 0xE000,
+        0x7000, 0xF800, 0xF800, 0xF800, 0x7000,
+        0x3800, 0x7C00, 0xFE00, 0xFE00, 0xFE00, 0x7C00, 0x3800,
+        0x1C00, 0x7F00, 0xFF80, 0xFF80, 0xFF80, 0xFF80, 0xFF80, 0x7F00, 0x1C00,
+        0x0E00, 0x3F80, 0x7FC0, 0x7FC0, 0xFFE0, 0xFFE0, 0xFFE0, 0x7FC0, 0x7FC0,
+        0x3F80, 0x1F00, 0x0E00,
+        0x0F80, 0x3FE0, 0x7FF0, 0x7FF0, 0xFFF8, 0xFFF8, 0xFFF8, 0xFFF8, 0xFFF8,
+        0x7FF0, 0x7FF0, 0x3FE0, 0x0F80,
+        0x07C0, 0x1FF0, 0x3FF8, 0x7FFC, 0x7FFC, 0xFFFE, 0xFFFE, 0xFFFE, 0xFFFE,
+        0xFFFE, 0x7FFC, 0x7FFC, 0x3FF8, 0x1FF0, 0x07C0,
+    };
+
+    int size = pic->pen & 0x07;
+    bool rectangle = pic->pen & 0x10;
+    bool spray = pic->pen & 0x20;
+    const Uint16 * circle = &circles[circle_offsets[size]];
+
+    // Center the pen on (x, y), keeping it on the screen.
+    int left = SDL_clamp(x * 2 - size, 0, PIC_WIDTH * 2 - size * 2) / 2;
+    int top = SDL_clamp(y - size, 0, PIC_HEIGHT - 1 - size * 2);
+    int bottom = top + size * 2 + 1;
+    int width = (size * 2 + 1) * 2;
+    Uint8 pattern = pic->texture | 0x01;
+
+    for ( int py = top; py < bottom; py++ ) {
+        Uint16 bits = *circle++;
+        int px = left;
+
+        for ( int i = 0; i <= width; i += 4, px++ ) {
+            if ( !rectangle && !(bits & (0x8000 >> (i / 2))) ) {
+                continue;
+            }
+
+            if ( spray ) {
+                bool carry = pattern & 1;
+                pattern >>= 1;
+                if ( carry ) {
+                    pattern ^= 0xB8;
+                }
+
+                if ( (pattern & 0x03) != 0x02 ) {
+                    continue;
+                }
+            }
+
+            Plot(pic, px, py);
+        }
+    }
+}
+
+
+
+/// Record the canvas as a frame, sharing its rows.
+static bool
+TakeFrame(Picture * pic, int num_commands)
+{
+    PicDrawing * drawing = pic->drawing;
+    PicFrame * frames = SDL_realloc(drawing->frames,
+                                    (drawing->num_frames + 1) * sizeof(*frames));
+    if ( frames == NULL ) {
+        return false;
+    }
+    drawing->frames = frames;
+
+    PicFrame * frame = &frames[drawing->num_frames++];
+    frame->num_commands = num_commands;
+    for ( int y = 0; y < PIC_HEIGHT; y++ ) {
+        frame->rows[y] = pic->rows[y];
+        frame->rows[y]->references++;
+    }
+
+    return true;
+}
+
+
+
+/// Draw a picture, recording a frame after every `interval` commands, or
+/// only the finished picture if `interval` is 0. The last frame is always the
+/// finished picture.
+bool
+DrawPicture(PicDrawing * drawing, const Uint8 * data, size_t size, int interval)
+{
+    SDL_zerop(drawing);
+
+    Picture * pic = SDL_calloc(1, sizeof(*pic));
+    if ( pic == NULL ) {
+        return false;
+    }
+    pic->data = data;
+    pic->size = size;
+    pic->drawing = drawing;
+
+    // Every row starts shared with the first; drawing copies them as needed.
+    PicRow * blank = SDL_malloc(sizeof(*blank));
+    if ( blank == NULL ) {
+        SDL_free(pic);
+        return false;
+    }
+    blank->references = PIC_HEIGHT;
+    memset(blank->visual, VISUAL_BACKGROUND, sizeof(blank->visual));
+    memset(blank->priority, PRIORITY_BACKGROUND, sizeof(blank->priority));
+    for ( int y = 0; y < PIC_HEIGHT; y++ ) {
+        pic->rows[y] = blank;
+    }
+
+    int num_commands = 0;
+    int last_frame = -1;
+    bool ok = true;
+
+    while ( pic->pos < pic->size ) {
+        Uint8 command = pic->data[pic->pos++];
+        if ( command == 0xFF ) {
+            break;
+        }
+
+        if ( command < 0xF0 ) {
+            continue; // A stray operand.
+        }
+
+        int x1, y1, x2, y2, operand;
+        switch ( command ) {
+            case 0xF0: // Set visual color.
+                pic->visual_color = NextOperand(pic) & 0x0F;
+                pic->visual_on = true;
+                break;
+            case 0xF1: // Visual off.
+                pic->visual_on = false;
+                break;
+            case 0xF2: // Set priority color.
+                pic->priority_color = NextOperand(pic) & 0x0F;
+                pic->priority_on = true;
+                break;
+            case 0xF3: // Priority off.
+                pic->priority_on = false;
+                break;
+            case 0xF4: // Y corner: alternating vertical and horizontal lines.
+            case 0xF5: // X corner: alternating horizontal and vertical lines.
+                if ( (x1 = NextOperand(pic)) < 0 || (y1 = NextOperand(pic)) < 0 ) {
+                    break;
+                }
+                Plot(pic, x1, y1);
+
+                for ( bool vertical = command == 0xF4; ; vertical = !vertical ) {
+                    if ( (operand = NextOperand(pic)) < 0 ) {
+                        break;
+                    }
+                    if ( vertical ) {
+                        DrawLine(pic, x1, y1, x1, operand);
+                        y1 = operand;
+                    } else {
+                        DrawLine(pic, x1, y1, operand, y1);
+                        x1 = operand;
+                    }
+                }
+                break;
+            case 0xF6: // Absolute lines.
+                if ( (x1 = NextOperand(pic)) < 0 || (y1 = NextOperand(pic)) < 0 ) {
+                    break;
+                }
+                Plot(pic, x1, y1);
+
+                while ( (x2 = NextOperand(pic)) >= 0 && (y2 = NextOperand(pic)) >= 0 ) {
+                    DrawLine(pic, x1, y1, x2, y2);
+                    x1 = x2;
+                    y1 = y2;
+                }
+                break;
+            case 0xF7: // Relative lines: each operand holds a signed 3-bit
+                       // step in each nibble, x high.
+                if ( (x1 = NextOperand(pic)) < 0 || (y1 = NextOperand(pic)) < 0 ) {
+                    break;
+                }
+                Plot(pic, x1, y1);
+
+                while ( (operand = NextOperand(pic)) >= 0 ) {
+                    int dx = (operand >> 4) & 0x07;
+                    int dy = operand & 0x07;
+                    x2 = x1 + (operand & 0x80 ? -dx : dx);
+                    y2 = y1 + (operand & 0x08 ? -dy : dy);
+                    x2 = SDL_clamp(x2, 0, PIC_WIDTH - 1);
+                    y2 = SDL_clamp(y2, 0, PIC_HEIGHT - 1);
+                    DrawLine(pic, x1, y1, x2, y2);
+                    x1 = x2;
+                    y1 = y2;
+                }
+                break;
+            case 0xF8: // Fill.
+                while ( (x1 = NextOperand(pic)) >= 0 && (y1 = NextOperand(pic)) >= 0 ) {
+                    Fill(pic, x1, y1);
+                }
+                break;
+            case 0xF9: // Set pen.
+                if ( (operand = NextOperand(pic)) >= 0 ) {
+                    pic->pen = operand;
+                }
+                break;
+            case 0xFA: // Plot with pen; a sprayed pen's points each start
+                       // with a pattern number.
+                for ( ;; ) {
+                    if ( pic->pen & 0x20 ) {
+                        if ( (operand = NextOperand(pic)) < 0 ) {
+                            break;
+                        }
+                        pic->texture = (operand >> 1) & 0x7F;
+                    }
+
+                    if ( (x1 = NextOperand(pic)) < 0 || (y1 = NextOperand(pic)) < 0 ) {
+                        break;
+                    }
+                    PlotPen(pic, x1, y1);
+                }
+                break;
+            default: // Unknown: skip its operands.
+                while ( NextOperand(pic) >= 0 ) { }
+                break;
+        }
+
+        num_commands++;
+        if ( interval > 0 && num_commands % interval == 0 ) {
+            ok &= TakeFrame(pic, num_commands);
+            last_frame = num_commands;
+        }
+    }
+
+    if ( last_frame != num_commands ) {
+        ok &= TakeFrame(pic, num_commands);
+    }
+
+    for ( int y = 0; y < PIC_HEIGHT; y++ ) {
+        if ( --pic->rows[y]->references == 0 ) {
+            SDL_free(pic->rows[y]);
+        }
+    }
+    SDL_free(pic);
+
+    if ( !ok ) {
+        FreePicDrawing(drawing);
+        SDL_OutOfMemory();
+    }
+
+    return ok;
+}
+
+
+
+/// Render a frame's visual or priority screen, with pixels doubled in width
+/// as displayed.
+SDL_Surface *
+RenderPicFrame(const PicFrame * frame, bool priority)
+{
+    SDL_Surface * s = SDL_CreateSurface(PIC_WIDTH * 2, PIC_HEIGHT, SDL_PIXELFORMAT_RGBA32);
+    if ( s == NULL ) {
+        return NULL;
+    }
+
+    const SDL_PixelFormatDetails * details = SDL_GetPixelFormatDetails(s->format);
+    Uint32 colors[16];
+    for ( int i = 0; i < 16; i++ ) {
+        colors[i] = SDL_MapRGBA(details, NULL, pal[i].r, pal[i].g, pal[i].b, 255);
+    }
+
+    for ( int y = 0; y < PIC_HEIGHT; y++ ) {
+        const PicRow * row = frame->rows[y];
+        const Uint8 * src = priority ? row->priority : row->visual;
+        Uint32 * dst = (Uint32 *)((Uint8 *)s->pixels + y * s->pitch);
+
+        for ( int x = 0; x < PIC_WIDTH; x++ ) {
+            dst[x * 2] = dst[x * 2 + 1] = colors[src[x]];
+        }
+    }
+
+    return s;
+}
+
+
+
+void
+FreePicDrawing(PicDrawing * drawing)
+{
+    for ( int i = 0; i < drawing->num_frames; i++ ) {
+        for ( int y = 0; y < PIC_HEIGHT; y++ ) {
+            PicRow * row = drawing->frames[i].rows[y];
+            if ( --row->references == 0 ) {
+                SDL_free(row);
+            }
+        }
+    }
+
+    SDL_free(drawing->frames);
+    SDL_zerop(drawing);
+}
@@ -0,0 +1,628 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// PNG output with parallel compression. Large images, such as contact
+// sheets, are filtered a row at a time on all cores, then split into
+// independent blocks that are deflated in parallel, in the manner of pigz:
+//
+//  - Each block may refer back into the 32 KB of data before it, which every
+//    worker can see since the whole filtered image is in memory.
+//  - Each block but the last ends with an empty stored block, which
+//    byte-aligns it, so compressed blocks can simply be concatenated.
+//  - Each block is written as its own IDAT chunk with its own CRC, and the
+//    per-block Adler-32 checksums are combined for the zlib trailer.
+//
+// Blocks use the fixed Huffman codes, which keeps each worker simple and
+// suits the long runs of flat color in View images.
+//
+
+#include "agi.h"
+
+#define PNG_BLOCK_SIZE (256 * 1024)    // Filtered bytes per compressed block.
+
+#define WINDOW_SIZE 32768
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+#define HASH_BITS 15
+#define HASH_SIZE (1 << HASH_BITS)
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define MAX_CHAIN 32
+#define MAX_STORED 65535
+
+#define ADLER_BASE 65521
+#define ADLER_NMAX 5552
+
+
+
+typedef struct {
+    Uint8 * data;
+    size_t length;
+    size_t capacity;
+    Uint32 bits;        // Pending bits, least significant first.
+    int num_bits;
+} BitWriter;
+
+
+
+typedef struct {
+    BitWriter out;
+    Uint32 adler;       // Of the block's uncompressed data.
+    Uint32 crc;         // Of its IDAT chunk.
+} Block;
+
+
+
+typedef struct {
+    const SDL_Surface * surface;
+    Uint8 * filtered;   // One filter type byte, then the row, for each row.
+    size_t size;
+    Block * blocks;
+    int num_blocks;
+} PNGJob;
+
+
+
+static const Uint16 length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const Uint8 length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const Uint16 distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+
+static const Uint8 distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static Uint32 crc_table[256];
+static SDL_InitState crc_table_init;
+
+
+
+static void
+InitCRCTable(void)
+{
+    if ( !SDL_ShouldInit(&crc_table_init) ) {
+        return;
+    }
+
+    for ( Uint32 i = 0; i < 256; i++ ) {
+        Uint32 c = i;
+        for ( int k = 0; k < 8; k++ ) {
+            c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+
+    SDL_SetInitialized(&crc_table_init, true);
+}
+
+
+
+static Uint32
+UpdateCRC(Uint32 crc, const Uint8 * data, size_t length)
+{
+    crc = ~crc;
+    for ( size_t i = 0; i < length; i++ ) {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+
+
+static Uint32
+Adler32(const Uint8 * data, size_t length)
+{
+    Uint32 a = 1;
+    Uint32 b = 0;
+
+    while ( length > 0 ) {
+        size_t n = SDL_min(length, ADLER_NMAX);
+        length -= n;
+        while ( n-- ) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+
+    return b << 16 | a;
+}
+
+
+
+/// The Adler-32 of two pieces of data joined, from the checksum of each and
+/// the length of the second.
+static Uint32
+CombineAdler32(Uint32 adler1, Uint32 adler2, size_t length2)
+{
+    Uint32 rem = length2 % ADLER_BASE;
+    Uint32 sum1 = adler1 & 0xFFFF;
+    Uint32 sum2 = (Uint32)(((Uint64)rem * sum1) % ADLER_BASE);
+
+    sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+
+    if ( sum1 >= ADLER_BASE ) sum1 -= ADLER_BASE;
+    if ( sum1 >= ADLER_BASE ) sum1 -= ADLER_BASE;
+    if ( sum2 >= ADLER_BASE * 2 ) sum2 -= ADLER_BASE * 2;
+    if ( sum2 >= ADLER_BASE ) sum2 -= ADLER_BASE;
+
+    return sum2 << 16 | sum1;
+}
+
+
+
+static void
+PutByte(BitWriter * w, Uint8 byte)
+{
+    if ( w->length == w->capacity ) {
+        w->capacity = w->capacity ? w->capacity * 2 : 4096;
+        w->data = SDL_realloc(w->data, w->capacity);
+    }
+
+    w->data[w->length++] = byte;
+}
+
+
+
+static void
+PutBits(BitWriter * w, Uint32 value, int count)
+{
+    w->bits |= value << w->num_bits;
+    w->num_bits += count;
+
+    while ( w->num_bits >= 8 ) {
+        PutByte(w, w->bits & 0xFF);
+        w->bits >>= 8;
+        w->num_bits -= 8;
+    }
+}
+
+
+
+/// Huffman codes are packed starting from their most significant bit.
+static void
+PutCode(BitWriter * w, Uint32 code, int length)
+{
+    Uint32 reversed = 0;
+    for ( int i = 0; i < length; i++ ) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+
+    PutBits(w, reversed, length);
+}
+
+
+
+static void
+AlignToByte(BitWriter * w)
+{
+    if ( w->num_bits > 0 ) {
+        PutBits(w, 0, 8 - w->num_bits);
+    }
+}
+
+
+
+/// Write a literal/length symbol with the fixed Huffman code.
+static void
+PutSymbol(BitWriter * w, int symbol)
+{
+    if ( symbol < 144 ) {
+        PutCode(w, 0x30 + symbol, 8);
+    } else if ( symbol < 256 ) {
+        PutCode(w, 0x190 + symbol - 144, 9);
+    } else if ( symbol < 280 ) {
+        PutCode(w, symbol - 256, 7);
+    } else {
+        PutCode(w, 0xC0 + symbol - 280, 8);
+    }
+}
+
+
+
+static void
+PutMatch(BitWriter * w, int length, int distance)
+{
+    int code = 28;
+    while ( length_base[code] > length ) {
+        code--;
+    }
+    PutSymbol(w, 257 + code);
+    PutBits(w, length - length_base[code], length_extra[code]);
+
+    code = 29;
+    while ( distance_base[code] > distance ) {
+        code--;
+    }
+    PutCode(w, code, 5);
+    PutBits(w, distance - distance_base[code], distance_extra[code]);
+}
+
+
+
+static Uint32
+Hash(const Uint8 * p)
+{
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (HASH_SIZE - 1);
+}
+
+
+
+/// Deflate data[start, end) with the fixed Huffman codes, finding matches
+/// with hash chains that also reach into the window before `start`. `size` is
+/// the length of all of `data`, which hashing must not read past.
+static void
+DeflateFixed(const Uint8 * data,
+             size_t size,
+             size_t start,
+             size_t end,
+             bool last,
+             BitWriter * w)
+{
+    int * head = SDL_malloc(HASH_SIZE * sizeof(*head));
+    int * prev = SDL_malloc(WINDOW_SIZE * sizeof(*prev));
+    for ( int i = 0; i < HASH_SIZE; i++ ) {
+        head[i] = -1;
+    }
+
+    size_t window_start = start > WINDOW_SIZE ? start - WINDOW_SIZE : 0;
+    for ( size_t pos = window_start; pos < start && pos + MIN_MATCH <= size; pos++ ) {
+        Uint32 h = Hash(data + pos);
+        prev[pos & WINDOW_MASK] = head[h];
+        head[h] = (int)pos;
+    }
+
+    PutBits(w, last, 1);
+    PutBits(w, 1, 2); // Fixed Huffman codes.
+
+    size_t pos = start;
+    while ( pos < end ) {
+        int best_length = 0;
+        int best_distance = 0;
+
+        if ( pos + MIN_MATCH <= end ) {
+            int max_length = (int)SDL_min(end - pos, MAX_MATCH);
+            Uint32 h = Hash(data + pos);
+            int candidate = head[h];
+
+            for ( int chain = 0; chain < MAX_CHAIN && candidate >= 0; chain++ ) {
+                if ( pos - candidate > WINDOW_SIZE ) {
+                    break;
+                }
+
+                const Uint8 * a = data + candidate;
+                const Uint8 * b = data + pos;
+                if ( a[best_length] == b[best_length] ) {
+                    int length = 0;
+                    while ( length < max_length && a[length] == b[length] ) {
+                        length++;
+                    }
+
+                    if ( length > best_length ) {
+                        best_length = length;
+                        best_distance = (int)(pos - candidate);
+                        if ( length == max_length ) {
+                            break;
+                        }
+                    }
+                }
+
+                int next = prev[candidate & WINDOW_MASK];
+                if ( next >= candidate ) {
+                    break; // Overwritten by a newer position.
+                }
+                candidate = next;
+            }
+        }
+
+        int advance = 1;
+        if ( best_length >= MIN_MATCH ) {
+            PutMatch(w, best_length, best_distance);
+            advance = best_length;
+        } else {
+            PutSymbol(w, data[pos]);
+        }
+
+        // Insert every position covered into the hash chains.
+        for ( int i = 0; i < advance; i++, pos++ ) {
+            if ( pos + MIN_MATCH <= end ) {
+                Uint32 h = Hash(data + pos);
+                prev[pos & WINDOW_MASK] = head[h];
+                head[h] = (int)pos;
+            }
+        }
+    }
+
+    PutSymbol(w, 256); // End of block.
+
+    if ( !last ) {
+        // An empty stored block, to end on a byte boundary.
+        PutBits(w, 0, 3);
+        AlignToByte(w);
+        PutByte(w, 0x00);
+        PutByte(w, 0x00);
+        PutByte(w, 0xFF);
+        PutByte(w, 0xFF);
+    }
+
+    AlignToByte(w);
+
+    SDL_free(head);
+    SDL_free(prev);
+}
+
+
+
+/// Store data[start, end) uncompressed, for data that doesn't compress.
+static void
+DeflateStored(const Uint8 * data, size_t start, size_t end, bool last, BitWriter * w)
+{
+    do {
+        size_t length = SDL_min(end - start, MAX_STORED);
+        PutBits(w, last && start + length == end, 1);
+        PutBits(w, 0, 2);
+        AlignToByte(w);
+        PutByte(w, length & 0xFF);
+        PutByte(w, length >> 8);
+        PutByte(w, ~length & 0xFF);
+        PutByte(w, (~length >> 8) & 0xFF);
+        for ( size_t i = 0; i < length; i++ ) {
+            PutByte(w, data[start + i]);
+        }
+        start += length;
+    } while ( start < end );
+}
+
+
+
+static int
+Paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = SDL_abs(p - a);
+    int pb = SDL_abs(p - b);
+    int pc = SDL_abs(p - c);
+
+    if ( pa <= pb && pa <= pc ) {
+        return a;
+    }
+
+    return pb <= pc ? b : c;
+}
+
+
+
+/// Filter one row with each of the five filters and keep the one with the
+/// smallest sum of absolute differences.
+static void
+FilterRow(int y, void * context)
+{
+    PNGJob * job = context;
+    const SDL_Surface * s = job->surface;
+    size_t row_size = (size_t)s->w * 4;
+    const Uint8 * row = (const Uint8 *)s->pixels + y * s->pitch;
+    const Uint8 * above = y > 0 ? row - s->pitch : NULL;
+    Uint8 * out = job->filtered + y * (row_size + 1);
+
+    Uint8 * candidate = SDL_malloc(row_size);
+    Uint32 best_sum = UINT32_MAX;
+
+    for ( int filter = 0; filter < 5; filter++ ) {
+        Uint32 sum = 0;
+        for ( size_t i = 0; i < row_size; i++ ) {
+            int a = i >= 4 ? row[i - 4] : 0;
+            int b = above ? above[i] : 0;
+            int c = i >= 4 && above ? above[i - 4] : 0;
+            int predicted = 0;
+
+            switch ( filter ) {
+                case 1: predicted = a; break;
+                case 2: predicted = b; break;
+                case 3: predicted = (a + b) / 2; break;
+                case 4: predicted = Paeth(a, b, c); break;
+            }
+
+            candidate[i] = (Uint8)(row[i] - predicted);
+            sum += (Sint8)candidate[i] < 0 ? -(Sint8)candidate[i] : candidate[i];
+        }
+
+        if ( sum < best_sum ) {
+            best_sum = sum;
+            out[0] = filter;
+            memcpy(out + 1, candidate, row_size);
+        }
+    }
+
+    SDL_free(candidate);
+}
+
+
+
+static void
+CompressBlock(int index, void * context)
+{
+    PNGJob * job = context;
+    Block * block = &job->blocks[index];
+    size_t start = (size_t)index * PNG_BLOCK_SIZE;
+    size_t end = SDL_min(start + PNG_BLOCK_SIZE, job->size);
+    bool last = index == job->num_blocks - 1;
+
+    // Room for the chunk type, so the CRC can be computed over both.
+    PutBits(&block->out, 'I' | 'D' << 8 | 'A' << 16, 24);
+    PutBits(&block->out, 'T', 8);
+
+    if ( index == 0 ) {
+        PutByte(&block->out, 0x78); // zlib header: deflate, 32 KB window.
+        PutByte(&block->out, 0x01);
+    }
+
+    size_t header_length = block->out.length;
+    DeflateFixed(job->filtered, job->size, start, end, last, &block->out);
+
+    size_t stored_length = end - start + 5 * ((end - start) / MAX_STORED + 1);
+    if ( block->out.length - header_length > stored_length ) {
+        block->out.length = header_length;
+        DeflateStored(job->filtered, start, end, last, &block->out);
+    }
+
+    block->adler = Adler32(job->filtered + start, end - start);
+    block->crc = UpdateCRC(0, block->out.data, block->out.length);
+}
+
+
+
+static void
+PutUint32(BitWriter * w, Uint32 value)
+{
+    PutByte(w, value >> 24);
+    PutByte(w, value >> 16);
+    PutByte(w, value >> 8);
+    PutByte(w, value);
+}
+
+
+
+/// Append a chunk whose type and data are in `data`, which is `length` bytes.
+static void
+PutChunk(BitWriter * w, const Uint8 * data, size_t length, Uint32 crc)
+{
+    PutUint32(w, (Uint32)(length - 4));
+    for ( size_t i = 0; i < length; i++ ) {
+        PutByte(w, data[i]);
+    }
+    PutUint32(w, crc);
+}
+
+
+
+/// Save an RGBA32 surface as a PNG, compressing on up to `num_threads`
+/// threads (zero or less for one per core).
+bool
+SavePNG(SDL_Surface * surface, const char * path, int num_threads)
+{
+    if ( surface->format != SDL_PIXELFORMAT_RGBA32 ) {
+        return SDL_SetError("SavePNG: surface is not RGBA32");
+    }
+
+    InitCRCTable();
+
+    PNGJob job = { .surface = surface };
+    job.size = (size_t)surface->h * (surface->w * 4 + 1);
+    job.filtered = SDL_malloc(SDL_max(job.size, 1));
+    job.num_blocks = (int)SDL_max((job.size + PNG_BLOCK_SIZE - 1) / PNG_BLOCK_SIZE, 1);
+    job.blocks = SDL_calloc(job.num_blocks, sizeof(*job.blocks));
+    if ( job.filtered == NULL || job.blocks == NULL ) {
+        SDL_free(job.filtered);
+        SDL_free(job.blocks);
+        return SDL_OutOfMemory();
+    }
+
+    RunParallel(surface->h, num_threads, FilterRow, &job);
+    RunParallel(job.num_blocks, num_threads, CompressBlock, &job);
+
+    BitWriter file = { 0 };
+    static const Uint8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    for ( int i = 0; i < 8; i++ ) {
+        PutByte(&file, signature[i]);
+    }
+
+    Uint8 header[17] = { 'I', 'H', 'D', 'R' };
+    header[4] = surface->w >> 24;
+    header[5] = surface->w >> 16;
+    header[6] = surface->w >> 8;
+    header[7] = surface->w;
+    header[8] = surface->h >> 24;
+    header[9] = surface->h >> 16;
+    header[10] = surface->h >> 8;
+    header[11] = surface->h;
+    header[12] = 8; // Bits per channel.
+    header[13] = 6; // RGBA.
+    PutChunk(&file, header, sizeof(header), UpdateCRC(0, header, sizeof(header)));
+
+    Uint32 adler = job.blocks[0].adler;
+    size_t start = 0;
+    for ( int i = 0; i < job.num_blocks; i++ ) {
+        Block * block = &job.blocks[i];
+        size_t length = SDL_min(job.size - start, PNG_BLOCK_SIZE);
+        if ( i > 0 ) {
+            adler = CombineAdler32(adler, block->adler, length);
+        }
+        start += length;
+
+        PutChunk(&file, block->out.data, block->out.length, block->crc);
+        SDL_free(block->out.data);
+    }
+
+    Uint8 trailer[8] = { 'I', 'D', 'A', 'T', adler >> 24, adler >> 16, adler >> 8, adler };
+    PutChunk(&file, trailer, sizeof(trailer), UpdateCRC(0, trailer, sizeof(trailer)));
+
+    Uint8 end[4] = { 'I', 'E', 'N', 'D' };
+    PutChunk(&file, end, sizeof(end), UpdateCRC(0, end, sizeof(end)));
+
+    bool ok = SDL_SaveFile(path, file.data, file.length);
+
+    SDL_free(file.data);
+    SDL_free(job.blocks);
+    SDL_free(job.filtered);
+
+    return ok;
+}
+
+
+
+/// Save a surface as a PNG, DDS or KTX2 file if `path` ends in ".png",
+/// ".dds" or ".ktx2", or else as a BMP.
+bool
+SaveImage(SDL_Surface * surface, const char * path, int num_threads)
+{
+    size_t length = strlen(path);
+    if ( length >= 4 && SDL_strcasecmp(path + length - 4, ".png") == 0 ) {
+        return SavePNG(surface, path, num_threads);
+    }
+
+    if ( length >= 4 && SDL_strcasecmp(path + length - 4, ".dds") == 0 ) {
+        return SaveDDS(surface, path);
+    }
+
+    if ( length >= 5 && SDL_strcasecmp(path + length - 5, ".ktx2") == 0 ) {
+        return SaveKTX2(surface, path);
+    }
+
+    return SDL_SaveBMP(surface, path);
+}
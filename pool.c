@@ -0,0 +1,133 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#include "agi.h"
+
+typedef struct {
+    SDL_AtomicInt next;
+    int count;
+    WorkFunc func;
+    void * context;
+} Pool;
+
+
+
+typedef struct {
+    Pool * pool;
+    int index;
+} WorkerInfo;
+
+
+
+static bool
+PoolDone(void * context)
+{
+    Pool * pool = context;
+    return SDL_GetAtomicInt(&pool->next) >= pool->count;
+}
+
+
+
+/// Take work items until there are none left. Under a make jobserver, every
+/// worker but the first holds a token while working on an item.
+static int
+Worker(void * data)
+{
+    WorkerInfo * info = data;
+    Pool * pool = info->pool;
+    bool needs_token = info->index > 0 && JobserverActive();
+
+    while ( 1 ) {
+        Uint8 token;
+        if ( needs_token && !JobserverAcquire(&token, PoolDone, pool) ) {
+            break;
+        }
+
+        int index = SDL_AddAtomicInt(&pool->next, 1);
+        if ( index < pool->count ) {
+            pool->func(index, pool->context);
+        }
+
+        if ( needs_token ) {
+            JobserverRelease(token);
+        }
+
+        if ( index >= pool->count ) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+
+
+/// Return the number of worker threads to use when `requested` is zero or
+/// less: one per logical core.
+int
+GetNumThreads(int requested)
+{
+    if ( requested > 0 ) {
+        return requested;
+    }
+
+    return SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+}
+
+
+
+/// Call `func` once for every index in [0, count), spread across `num_threads`
+/// threads (the calling thread included). Returns when all calls are done.
+/// Under a make jobserver, threads beyond the first only run while they hold
+/// a token, so the effective thread count follows make's -j.
+void
+RunParallel(int count, int num_threads, WorkFunc func, void * context)
+{
+    if ( count <= 0 ) {
+        return;
+    }
+
+    Pool pool = { .count = count, .func = func, .context = context };
+    SDL_SetAtomicInt(&pool.next, 0);
+
+    num_threads = SDL_min(GetNumThreads(num_threads), count);
+
+    SDL_Thread ** threads = SDL_calloc(num_threads, sizeof(SDL_Thread *));
+    WorkerInfo * info = SDL_calloc(num_threads, sizeof(WorkerInfo));
+    for ( int i = 0; i < num_threads; i++ ) {
+        info[i] = (WorkerInfo){ &pool, i };
+        if ( i > 0 ) {
+            threads[i] = SDL_CreateThread(Worker, "worker", &info[i]);
+        }
+    }
+
+    Worker(&info[0]);
+
+    for ( int i = 1; i < num_threads; i++ ) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    SDL_free(threads);
+    SDL_free(info);
+}
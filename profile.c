@@ -0,0 +1,559 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Workload profiling: histograms of what real View data looks like, and a
+// generator of synthetic games with the same distributions for benchmarking.
+//
+// A profile file has one histogram per line: its name, its number of
+// buckets, and the count in each bucket, e.g. "run_length 16 0 5120 ...".
+//
+
+#include "agi.h"
+#include <errno.h>
+
+#define MAX_VOL_SIZE 0x100000 // VIEWDIR offsets are 20 bits.
+#define MAX_VOLS 16 // VIEWDIR volume numbers are 4 bits.
+#define MAX_RESOURCE_SIZE 0xFFFF
+
+
+
+typedef struct {
+    const char * name;
+    int size;
+    Uint64 counts[256];
+} Histogram;
+
+
+
+typedef struct {
+    Histogram run_length;         // Length of each run, 0-15.
+    Histogram runs_per_row;
+    Histogram cel_width;
+    Histogram cel_height;
+    Histogram loops_per_view;
+    Histogram cels_per_loop;
+    Histogram mirrored_loop;      // 0: drawn as stored, 1: mirrored copy.
+    Histogram transparent_percent;
+    Histogram transparency_color;
+} Profile;
+
+
+
+static void
+InitProfile(Profile * profile)
+{
+    SDL_zerop(profile);
+    profile->run_length = (Histogram){ .name = "run_length", .size = 16 };
+    profile->runs_per_row = (Histogram){ .name = "runs_per_row", .size = 256 };
+    profile->cel_width = (Histogram){ .name = "cel_width", .size = 256 };
+    profile->cel_height = (Histogram){ .name = "cel_height", .size = 256 };
+    profile->loops_per_view = (Histogram){ .name = "loops_per_view", .size = 256 };
+    profile->cels_per_loop = (Histogram){ .name = "cels_per_loop", .size = 256 };
+    profile->mirrored_loop = (Histogram){ .name = "mirrored_loop", .size = 2 };
+    profile->transparent_percent = (Histogram){ .name = "transparent_percent", .size = 101 };
+    profile->transparency_color = (Histogram){ .name = "transparency_color", .size = 16 };
+}
+
+
+
+static Histogram *
+GetHistograms(Profile * profile, int * count)
+{
+    *count = sizeof(*profile) / sizeof(Histogram);
+    return (Histogram *)profile;
+}
+
+
+
+static void
+Add(Histogram * histogram, int value)
+{
+    histogram->counts[SDL_clamp(value, 0, histogram->size - 1)]++;
+}
+
+
+
+static void
+ProfileCel(Profile * profile, const View * view, int loop_num, int cel_num, Uint8 * pixels)
+{
+    const Cel * cel = &view->loops[loop_num].cels[cel_num];
+
+    Add(&profile->cel_width, cel->width);
+    Add(&profile->cel_height, cel->height);
+    Add(&profile->transparency_color, cel->transparency_color);
+
+    size_t pos = cel->data_offset;
+    for ( int y = 0; y < cel->height && pos < view->size; y++ ) {
+        int runs = 0;
+        while ( pos < view->size ) {
+            Uint8 byte = view->data[pos++];
+            if ( byte == 0 ) {
+                break;
+            }
+
+            Add(&profile->run_length, byte & 0x0F);
+            runs++;
+        }
+
+        Add(&profile->runs_per_row, runs);
+    }
+
+    int size = cel->width * cel->height;
+    int transparent = 0;
+
+    DecodeCel(view, loop_num, cel_num, pixels, cel->width);
+    for ( int i = 0; i < size; i++ ) {
+        transparent += pixels[i] == cel->transparency_color;
+    }
+
+    Add(&profile->transparent_percent, size ? transparent * 100 / size : 0);
+}
+
+
+
+static void
+ProfileView(Profile * profile, const View * view, Uint8 * pixels)
+{
+    Add(&profile->loops_per_view, view->num_loops);
+
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        const Loop * loop = &view->loops[i];
+        Add(&profile->cels_per_loop, loop->num_cels);
+
+        // A mirrored loop reuses another loop's cels, so only its existence
+        // is counted.
+        bool mirrored = loop->num_cels > 0;
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            mirrored &= CelIsMirrored(view, i, &loop->cels[j]);
+        }
+
+        Add(&profile->mirrored_loop, mirrored);
+        if ( mirrored ) {
+            continue;
+        }
+
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            ProfileCel(profile, view, i, j, pixels);
+        }
+    }
+}
+
+
+
+static void
+PrintSummary(const Histogram * histogram)
+{
+    Uint64 total = 0;
+    Uint64 sum = 0;
+    int max = 0;
+    for ( int i = 0; i < histogram->size; i++ ) {
+        total += histogram->counts[i];
+        sum += histogram->counts[i] * i;
+        if ( histogram->counts[i] ) {
+            max = i;
+        }
+    }
+
+    if ( total == 0 ) {
+        printf("%-20s (no samples)\n", histogram->name);
+        return;
+    }
+
+    // Find the 50th, 90th and 99th percentiles.
+    int percentiles[3] = { 50, 90, 99 };
+    int values[3] = { 0 };
+    Uint64 seen = 0;
+    int p = 0;
+    for ( int i = 0; i < histogram->size && p < 3; i++ ) {
+        seen += histogram->counts[i];
+        while ( p < 3 && seen * 100 >= total * percentiles[p] ) {
+            values[p++] = i;
+        }
+    }
+
+    printf("%-20s %10" SDL_PRIu64 " %8.2f %5d %5d %5d %5d\n",
+           histogram->name,
+           total,
+           (double)sum / total,
+           values[0],
+           values[1],
+           values[2],
+           max);
+}
+
+
+
+/// Profile every View in the list, print a summary and, if `path` is given,
+/// save the histograms there for -synth.
+bool
+ProfileViews(const ViewList * list, const char * path)
+{
+    Profile profile;
+    InitProfile(&profile);
+
+    View * view = SDL_malloc(sizeof(*view));
+    Uint8 * pixels = SDL_malloc(MAX_CEL_WIDTH * MAX_CEL_HEIGHT);
+    int num_views = 0;
+    for ( int i = 0; i < list->num_views; i++ ) {
+        // The profile describes AGI's RLE encoding, so other engines' Views
+        // are left out.
+        if ( list->views[i].format == VIEW_AGI
+            && ParseViewResource(view, &list->views[i]) ) {
+            ProfileView(&profile, view, pixels);
+            ReleaseView(view);
+            num_views++;
+        }
+    }
+    SDL_free(pixels);
+    SDL_free(view);
+
+    int count;
+    Histogram * histograms = GetHistograms(&profile, &count);
+
+    printf("%d Views profiled\n", num_views);
+    printf("%-20s %10s %8s %5s %5s %5s %5s\n",
+           "", "samples", "mean", "p50", "p90", "p99", "max");
+    for ( int i = 0; i < count; i++ ) {
+        PrintSummary(&histograms[i]);
+    }
+
+    if ( path == NULL ) {
+        return true;
+    }
+
+    FILE * file = fopen(path, "w");
+    if ( file == NULL ) {
+        printf("Error: could not create '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    for ( int i = 0; i < count; i++ ) {
+        fprintf(file, "%s %d", histograms[i].name, histograms[i].size);
+        for ( int j = 0; j < histograms[i].size; j++ ) {
+            fprintf(file, " %" SDL_PRIu64, histograms[i].counts[j]);
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    printf("saved %s\n", path);
+
+    return true;
+}
+
+
+
+static bool
+LoadProfile(Profile * profile, const char * path)
+{
+    InitProfile(profile);
+
+    FILE * file = fopen(path, "r");
+    if ( file == NULL ) {
+        printf("Error: could not open profile '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    int count;
+    Histogram * histograms = GetHistograms(profile, &count);
+    char name[64];
+    int size;
+    bool ok = true;
+
+    while ( ok && fscanf(file, "%63s %d", name, &size) == 2 ) {
+        Histogram * histogram = NULL;
+        for ( int i = 0; i < count; i++ ) {
+            if ( strcmp(histograms[i].name, name) == 0 ) {
+                histogram = &histograms[i];
+            }
+        }
+
+        ok = histogram && size == histogram->size;
+        for ( int i = 0; ok && i < size; i++ ) {
+            ok = fscanf(file, "%" SDL_PRIu64, &histogram->counts[i]) == 1;
+        }
+    }
+
+    fclose(file);
+    if ( !ok ) {
+        printf("Error: '%s' is not a valid profile\n", path);
+    }
+
+    return ok;
+}
+
+
+
+static Uint32
+Random(Uint64 * state)
+{
+    // xorshift64*
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (Uint32)((*state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+
+
+/// Draw a value from a histogram's distribution, or return `fallback` if it
+/// has no samples.
+static int
+Sample(const Histogram * histogram, Uint64 * state, int fallback)
+{
+    Uint64 total = 0;
+    for ( int i = 0; i < histogram->size; i++ ) {
+        total += histogram->counts[i];
+    }
+
+    if ( total == 0 ) {
+        return fallback;
+    }
+
+    Uint64 r = (((Uint64)Random(state) << 32) | Random(state)) % total;
+    for ( int i = 0; i < histogram->size; i++ ) {
+        if ( r < histogram->counts[i] ) {
+            return i;
+        }
+        r -= histogram->counts[i];
+    }
+
+    return fallback;
+}
+
+
+
+typedef struct {
+    Uint8 * data;
+    size_t size;
+} Output;
+
+
+
+static void
+Emit(Output * out, Uint8 byte)
+{
+    if ( out->size < MAX_RESOURCE_SIZE ) {
+        out->data[out->size] = byte;
+    }
+    out->size++;
+}
+
+
+
+static void
+EmitWord(Output * out, size_t offset, Uint16 value)
+{
+    if ( offset + 1 < MAX_RESOURCE_SIZE ) {
+        out->data[offset] = value & 0xFF;
+        out->data[offset + 1] = value >> 8;
+    }
+}
+
+
+
+/// Write a cel's RLE rows, drawing run lengths from the profile and making
+/// runs transparent often enough to match the sampled transparency.
+static void
+SynthesizeCel(Output * out, const Profile * profile, Uint64 * state, int w, int h, int transparency)
+{
+    int transparent_percent = Sample(&profile->transparent_percent, state, 50);
+
+    for ( int y = 0; y < h; y++ ) {
+        int x = 0;
+        while ( x < w ) {
+            int count = Sample(&profile->run_length, state, 4);
+            count = SDL_clamp(count, 1, SDL_min(w - x, 15));
+
+            int color;
+            if ( (int)(Random(state) % 100) < transparent_percent ) {
+                color = transparency;
+            } else {
+                color = Random(state) % 16;
+            }
+
+            Emit(out, (color << 4) | count);
+            x += count;
+        }
+        Emit(out, 0);
+    }
+}
+
+
+
+/// Write one synthetic View resource into `out` (MAX_RESOURCE_SIZE bytes).
+/// Returns false if it didn't fit.
+static bool
+SynthesizeView(Output * out, const Profile * profile, Uint64 * state)
+{
+    int num_loops = SDL_max(Sample(&profile->loops_per_view, state, 4), 1);
+    out->size = 0;
+
+    // Header: two unknown bytes, number of loops, description offset (none),
+    // and the loop offsets.
+    Emit(out, 1);
+    Emit(out, 1);
+    Emit(out, num_loops);
+    Emit(out, 0);
+    Emit(out, 0);
+    size_t loop_offsets = out->size;
+    for ( int i = 0; i < num_loops; i++ ) {
+        Emit(out, 0);
+        Emit(out, 0);
+    }
+
+    size_t previous_offset = 0;
+    bool previous_mirrored = true;
+    for ( int i = 0; i < num_loops && out->size < MAX_RESOURCE_SIZE; i++ ) {
+        // A mirrored loop points at the previous loop's cels, whose headers
+        // record the loop (0-7) they are drawn unmirrored in.
+        if ( !previous_mirrored && i < 8 && Sample(&profile->mirrored_loop, state, 0) ) {
+            EmitWord(out, loop_offsets + i * 2, previous_offset);
+            Uint8 num_cels = out->data[previous_offset];
+            for ( int j = 0; j < num_cels; j++ ) {
+                size_t header = previous_offset + out->data[previous_offset + 1 + j * 2]
+                              + (out->data[previous_offset + 2 + j * 2] << 8);
+                out->data[header + 2] |= 0x80 | ((i - 1) << 4);
+            }
+            previous_mirrored = true;
+            continue;
+        }
+
+        size_t loop_offset = out->size;
+        int num_cels = SDL_max(Sample(&profile->cels_per_loop, state, 3), 1);
+        EmitWord(out, loop_offsets + i * 2, loop_offset);
+        previous_offset = loop_offset;
+
+        Emit(out, num_cels);
+        size_t cel_offsets = out->size;
+        for ( int j = 0; j < num_cels; j++ ) {
+            Emit(out, 0);
+            Emit(out, 0);
+        }
+
+        for ( int j = 0; j < num_cels && out->size < MAX_RESOURCE_SIZE; j++ ) {
+            int w = SDL_max(Sample(&profile->cel_width, state, 16), 1);
+            int h = SDL_max(Sample(&profile->cel_height, state, 32), 1);
+            int transparency = Sample(&profile->transparency_color, state, 0);
+
+            EmitWord(out, cel_offsets + j * 2, out->size - loop_offset);
+            Emit(out, w);
+            Emit(out, h);
+            Emit(out, transparency);
+            SynthesizeCel(out, profile, state, w, h, transparency);
+        }
+
+        // Only a loop that fit entirely can be mirrored.
+        previous_mirrored = out->size > MAX_RESOURCE_SIZE;
+    }
+
+    return out->size <= MAX_RESOURCE_SIZE;
+}
+
+
+
+static bool
+SaveVol(const char * directory, int vol_num, const Uint8 * data, size_t size)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/VOL.%d", directory, vol_num);
+
+    return SDL_SaveFile(path, data, size);
+}
+
+
+
+/// Generate a game directory of `count` synthetic Views (VIEWDIR and VOL
+/// files) whose structure follows the distributions in a profile.
+bool
+SynthesizeGame(const char * profile_path, const char * directory, int count, Uint64 seed)
+{
+    Profile profile;
+    if ( !LoadProfile(&profile, profile_path) ) {
+        return false;
+    }
+
+    Uint64 state = seed ? seed : 0x9E3779B97F4A7C15ull;
+    Output view = { SDL_malloc(MAX_RESOURCE_SIZE), 0 };
+    Uint8 * vol = SDL_malloc(MAX_VOL_SIZE);
+    size_t vol_size = 0;
+    int vol_num = 0;
+    bool ok = true;
+
+    count = SDL_clamp(count, 1, 256);
+    Uint8 * viewdir = SDL_malloc(count * 3);
+
+    for ( int i = 0; i < count && ok; i++ ) {
+        // Retry Views that come out too large for a resource.
+        int tries = 0;
+        while ( !SynthesizeView(&view, &profile, &state) && ++tries < 100 ) { }
+
+        if ( view.size > MAX_RESOURCE_SIZE ) {
+            printf("Error: profile makes Views too large for a resource\n");
+            ok = false;
+            break;
+        }
+
+        if ( vol_size + 5 + view.size > MAX_VOL_SIZE ) {
+            if ( vol_num + 1 == MAX_VOLS ) {
+                printf("Error: profile makes Views too large for %d VOL files\n", MAX_VOLS);
+                ok = false;
+                break;
+            }
+            ok = SaveVol(directory, vol_num++, vol, vol_size);
+            vol_size = 0;
+        }
+
+        viewdir[i * 3] = (vol_num << 4) | ((vol_size >> 16) & 0x0F);
+        viewdir[i * 3 + 1] = (vol_size >> 8) & 0xFF;
+        viewdir[i * 3 + 2] = vol_size & 0xFF;
+
+        vol[vol_size++] = 0x12;
+        vol[vol_size++] = 0x34;
+        vol[vol_size++] = vol_num;
+        vol[vol_size++] = view.size & 0xFF;
+        vol[vol_size++] = view.size >> 8;
+        memcpy(vol + vol_size, view.data, view.size);
+        vol_size += view.size;
+    }
+
+    if ( ok ) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/VIEWDIR", directory);
+        ok = SaveVol(directory, vol_num, vol, vol_size) && SDL_SaveFile(path, viewdir, count * 3);
+    }
+
+    if ( ok ) {
+        printf("saved %d synthetic Views in %s\n", count, directory);
+    } else {
+        printf("Error: could not save synthetic game in '%s': %s\n", directory, SDL_GetError());
+    }
+
+    SDL_free(viewdir);
+    SDL_free(vol);
+    SDL_free(view.data);
+
+    return ok;
+}
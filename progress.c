@@ -0,0 +1,303 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Progress reporting for batch conversions. Workers count finished files,
+// input bytes and errors in per-thread counters, each on its own cache line
+// and written only by its thread, so counting needs no locks or shared
+// read-modify-writes. A reporter thread sums them a few times a second and
+// rewrites one status line, and optionally a Prometheus textfile (for
+// node_exporter's textfile collector) via a temporary file and a rename.
+//
+
+#include "agi.h"
+#include <stdarg.h>
+
+#define MAX_PROGRESS_THREADS 256
+#define PROGRESS_INTERVAL_MS 500
+#define METRIC_PREFIX "agiview2bmp_"
+
+
+
+typedef struct {
+    // Only ever written by the owning thread; bytes wrap at 4 GB and are
+    // accumulated by the reporter.
+    _Alignas(64) SDL_AtomicU32 files;
+    SDL_AtomicU32 errors;
+    SDL_AtomicU32 bytes;
+} ThreadProgress;
+
+
+
+static struct {
+    bool active;
+    int total_files;
+    const char * metrics_path;
+    Uint64 start_ns;
+
+    ThreadProgress threads[MAX_PROGRESS_THREADS];
+    SDL_AtomicInt num_threads;
+
+    SDL_Thread * reporter;
+    SDL_Mutex * lock;
+    SDL_Condition * wake;
+    bool done;
+    int status_length;  // Characters on the status line, to clear.
+
+    // Reporter's running totals.
+    Uint32 last_bytes[MAX_PROGRESS_THREADS];
+    Uint64 bytes;
+    int files;
+    int errors;
+} progress;
+
+static _Thread_local ThreadProgress * thread_progress;
+
+
+
+/// Sum every thread's counters. Only called from one thread at a time.
+static void
+Sample(void)
+{
+    int num_threads = SDL_min(SDL_GetAtomicInt(&progress.num_threads), MAX_PROGRESS_THREADS);
+
+    progress.files = 0;
+    progress.errors = 0;
+    for ( int i = 0; i < num_threads; i++ ) {
+        ThreadProgress * thread = &progress.threads[i];
+        Uint32 bytes = SDL_GetAtomicU32(&thread->bytes);
+        progress.bytes += (Uint32)(bytes - progress.last_bytes[i]);
+        progress.last_bytes[i] = bytes;
+        progress.files += SDL_GetAtomicU32(&thread->files);
+        progress.errors += SDL_GetAtomicU32(&thread->errors);
+    }
+}
+
+
+
+static void
+WriteMetrics(double seconds, double files_per_second, double bytes_per_second, double eta)
+{
+    char temp_path[MAX_PATH_LENGTH + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", progress.metrics_path);
+
+    FILE * file = fopen(temp_path, "w");
+    if ( file == NULL ) {
+        return;
+    }
+
+    fprintf(file,
+            "# HELP " METRIC_PREFIX "files_total Files converted.\n"
+            "# TYPE " METRIC_PREFIX "files_total counter\n"
+            METRIC_PREFIX "files_total %d\n"
+            "# HELP " METRIC_PREFIX "errors_total Files that failed to convert.\n"
+            "# TYPE " METRIC_PREFIX "errors_total counter\n"
+            METRIC_PREFIX "errors_total %d\n"
+            "# HELP " METRIC_PREFIX "bytes_total View bytes read.\n"
+            "# TYPE " METRIC_PREFIX "bytes_total counter\n"
+            METRIC_PREFIX "bytes_total %llu\n"
+            "# HELP " METRIC_PREFIX "files_planned Files in this run.\n"
+            "# TYPE " METRIC_PREFIX "files_planned gauge\n"
+            METRIC_PREFIX "files_planned %d\n"
+            "# HELP " METRIC_PREFIX "files_per_second Average conversion rate.\n"
+            "# TYPE " METRIC_PREFIX "files_per_second gauge\n"
+            METRIC_PREFIX "files_per_second %.3f\n"
+            "# HELP " METRIC_PREFIX "bytes_per_second Average input rate.\n"
+            "# TYPE " METRIC_PREFIX "bytes_per_second gauge\n"
+            METRIC_PREFIX "bytes_per_second %.0f\n"
+            "# HELP " METRIC_PREFIX "eta_seconds Estimated time to finish.\n"
+            "# TYPE " METRIC_PREFIX "eta_seconds gauge\n"
+            METRIC_PREFIX "eta_seconds %.1f\n"
+            "# HELP " METRIC_PREFIX "elapsed_seconds Time since the run started.\n"
+            "# TYPE " METRIC_PREFIX "elapsed_seconds gauge\n"
+            METRIC_PREFIX "elapsed_seconds %.1f\n"
+            "# HELP " METRIC_PREFIX "running Whether the run is still going.\n"
+            "# TYPE " METRIC_PREFIX "running gauge\n"
+            METRIC_PREFIX "running %d\n",
+            progress.files + progress.errors,
+            progress.errors,
+            (unsigned long long)progress.bytes,
+            progress.total_files,
+            files_per_second,
+            bytes_per_second,
+            eta,
+            seconds,
+            !progress.done);
+
+    bool ok = fclose(file) == 0;
+    if ( !ok || !SDL_RenamePath(temp_path, progress.metrics_path) ) {
+        SDL_RemovePath(temp_path);
+    }
+}
+
+
+
+/// Print the status line and write the metrics file.
+static void
+Report(void)
+{
+    Sample();
+
+    double seconds = (SDL_GetTicksNS() - progress.start_ns) / 1e9;
+    int finished = progress.files + progress.errors;
+    double files_per_second = seconds > 0 ? finished / seconds : 0;
+    double bytes_per_second = seconds > 0 ? progress.bytes / seconds : 0;
+    double eta = files_per_second > 0
+        ? SDL_max(progress.total_files - finished, 0) / files_per_second
+        : 0;
+
+    progress.status_length = printf("\r%d/%d files, %.0f files/s, %.2f MB/s, ETA %ds, %d errors   ",
+                                    finished,
+                                    progress.total_files,
+                                    files_per_second,
+                                    bytes_per_second / (1024 * 1024),
+                                    (int)(eta + 0.5),
+                                    progress.errors) - 1;
+    fflush(stdout);
+
+    if ( progress.metrics_path ) {
+        WriteMetrics(seconds, files_per_second, bytes_per_second, eta);
+    }
+}
+
+
+
+static int
+Reporter(void * data)
+{
+    (void)data;
+
+    SDL_LockMutex(progress.lock);
+    while ( !progress.done ) {
+        SDL_WaitConditionTimeout(progress.wake, progress.lock, PROGRESS_INTERVAL_MS);
+        if ( !progress.done ) {
+            Report();
+        }
+    }
+    SDL_UnlockMutex(progress.lock);
+
+    return 0;
+}
+
+
+
+/// Start reporting progress on a batch of `total_files` Views. Per-View
+/// messages other than errors should be left out while it runs. Only one
+/// batch may be reported per run.
+void
+StartProgress(int total_files, const char * metrics_path)
+{
+    SDL_zero(progress);
+    progress.active = true;
+    progress.total_files = total_files;
+    progress.metrics_path = metrics_path;
+    progress.start_ns = SDL_GetTicksNS();
+    progress.lock = SDL_CreateMutex();
+    progress.wake = SDL_CreateCondition();
+    progress.reporter = SDL_CreateThread(Reporter, "progress", NULL);
+}
+
+
+
+bool
+ProgressActive(void)
+{
+    return progress.active;
+}
+
+
+
+/// Count a finished View of `size` bytes on the calling thread.
+void
+CountProgress(size_t size, bool ok)
+{
+    if ( !progress.active ) {
+        return;
+    }
+
+    if ( thread_progress == NULL ) {
+        int index = SDL_AddAtomicInt(&progress.num_threads, 1);
+        if ( index >= MAX_PROGRESS_THREADS ) {
+            return;
+        }
+        thread_progress = &progress.threads[index];
+    }
+
+    ThreadProgress * thread = thread_progress;
+    if ( ok ) {
+        SDL_SetAtomicU32(&thread->files, SDL_GetAtomicU32(&thread->files) + 1);
+    } else {
+        SDL_SetAtomicU32(&thread->errors, SDL_GetAtomicU32(&thread->errors) + 1);
+    }
+    SDL_SetAtomicU32(&thread->bytes, SDL_GetAtomicU32(&thread->bytes) + (Uint32)size);
+}
+
+
+
+/// Print a message, e.g. a worker's error, on a line of its own. While
+/// progress is reported, the status line is cleared first; it is drawn again
+/// at the next report.
+void
+PrintError(const char * format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    if ( progress.active ) {
+        SDL_LockMutex(progress.lock);
+        printf("\r%*s\r", progress.status_length, "");
+        progress.status_length = 0;
+        vprintf(format, args);
+        fflush(stdout);
+        SDL_UnlockMutex(progress.lock);
+    } else {
+        vprintf(format, args);
+    }
+
+    va_end(args);
+}
+
+
+
+/// Stop the reporter and print the final totals.
+void
+FinishProgress(void)
+{
+    if ( !progress.active ) {
+        return;
+    }
+
+    SDL_LockMutex(progress.lock);
+    progress.done = true;
+    SDL_SignalCondition(progress.wake);
+    SDL_UnlockMutex(progress.lock);
+    SDL_WaitThread(progress.reporter, NULL);
+
+    Report();
+    printf("\n");
+
+    SDL_DestroyCondition(progress.wake);
+    SDL_DestroyMutex(progress.lock);
+    progress.active = false;
+}
@@ -0,0 +1,216 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Directory-less VOL scanning, for games whose VIEWDIR is damaged or missing
+// and for VOL data arriving on a pipe. The VOL file is read once, front to
+// back, without seeking. Each resource starts with a 5-byte header:
+//
+//  12 34 vol len_lo len_hi
+//
+// Resources whose data looks like a View are handed to the caller as they are
+// found. Anything that doesn't parse as a header is skipped a byte at a time
+// until the next header is found.
+//
+
+#include "agi.h"
+
+#define SCAN_CHUNK_SIZE 0x10000
+#define SCAN_BUFFER_SIZE (SCAN_CHUNK_SIZE * 2 + 16)
+#define RESOURCE_HEADER_SIZE 5
+
+
+
+typedef struct {
+    FILE * file;
+    Uint8 * buffer;
+    size_t start;       // First unconsumed byte in buffer.
+    size_t end;         // End of buffered data.
+    Uint64 offset;      // Stream offset of buffer[start].
+    bool eof;
+} Stream;
+
+
+
+/// Read ahead until at least `count` bytes are buffered or the stream ends.
+/// Returns the number of bytes available.
+static size_t
+Fill(Stream * stream, size_t count)
+{
+    while ( stream->end - stream->start < count && !stream->eof ) {
+        if ( stream->start > 0 ) {
+            memmove(stream->buffer,
+                    stream->buffer + stream->start,
+                    stream->end - stream->start);
+            stream->end -= stream->start;
+            stream->start = 0;
+        }
+
+        size_t read = fread(stream->buffer + stream->end,
+                            1,
+                            SDL_min(SCAN_BUFFER_SIZE - stream->end, SCAN_CHUNK_SIZE),
+                            stream->file);
+        stream->end += read;
+        stream->eof = read == 0;
+    }
+
+    return stream->end - stream->start;
+}
+
+
+
+static void
+Consume(Stream * stream, size_t count)
+{
+    stream->start += count;
+    stream->offset += count;
+}
+
+
+
+/// Stricter checks than ParseView, so that logic, picture and sound
+/// resources, which can happen to parse, are not taken for Views: every cel
+/// must have a sane size and RLE data that ends each of its rows within the
+/// resource.
+static bool
+LooksLikeView(const View * view)
+{
+    size_t min_offset = 5 + view->num_loops * 2;
+
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        const Loop * loop = &view->loops[i];
+        if ( loop->offset < min_offset || loop->num_cels == 0 ) {
+            return false;
+        }
+
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            const Cel * cel = &loop->cels[j];
+            if ( cel->width == 0 || cel->width > 160
+                || cel->height == 0 || cel->height > 168
+                || cel->unmirrored_loop_num >= view->num_loops ) {
+                return false;
+            }
+
+            size_t pos = cel->data_offset;
+            for ( int y = 0; y < cel->height; y++ ) {
+                int x = 0;
+                while ( pos < view->size && view->data[pos] != 0 ) {
+                    x += view->data[pos++] & 0x0F;
+                }
+
+                if ( pos++ >= view->size || x > cel->width ) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Scan a VOL file, or standard input if `path` is "-", calling `func` for
+/// each View found. Views are named after the input and their offset in it,
+/// e.g. "VOL.1.00A3F2". Returns false if the input could not be read.
+bool
+ScanVolume(const char * path, ScanFunc func, void * context)
+{
+    bool is_stdin = strcmp(path, "-") == 0;
+    Stream stream = { .file = is_stdin ? stdin : fopen(path, "rb") };
+    if ( stream.file == NULL ) {
+        printf("Error: could not open '%s'\n", path);
+        return false;
+    }
+
+    stream.buffer = SDL_malloc(SCAN_BUFFER_SIZE);
+    View * view = SDL_malloc(sizeof(*view));
+    int num_views = 0;
+    int num_others = 0;
+    Uint64 num_skipped = 0;
+
+    while ( Fill(&stream, RESOURCE_HEADER_SIZE) >= RESOURCE_HEADER_SIZE ) {
+        const Uint8 * header = stream.buffer + stream.start;
+
+        if ( header[0] == 0x12 && header[1] == 0x34 && header[2] < 16 ) {
+            size_t length = header[3] | header[4] << 8;
+            size_t total = RESOURCE_HEADER_SIZE + length;
+
+            // Also read the following two bytes to check for another header.
+            size_t available = Fill(&stream, total + 2);
+            const Uint8 * data = stream.buffer + stream.start + RESOURCE_HEADER_SIZE;
+
+            if ( length > 0 && available >= total ) {
+                if ( ParseView(view, data, length) && LooksLikeView(view) ) {
+                    // A stream has no file identity to key the View by.
+                    ViewResource resource = {
+                        .number = -1,
+                        .data = data,
+                        .size = length,
+                        .key = ContentKey(data, length),
+                    };
+                    snprintf(resource.name, sizeof(resource.name), "%s.%06llX",
+                             is_stdin ? "stdin" : path,
+                             (unsigned long long)stream.offset);
+                    if ( !is_stdin ) {
+                        SetViewInputs(&resource, path, NULL);
+                    }
+
+                    func(&resource, context);
+                    num_views++;
+                    Consume(&stream, total);
+                    continue;
+                }
+
+                // Some other resource: trust the header only if it is followed
+                // by another one or by the end of the file.
+                if ( available == total
+                    || (available >= total + 2 && data[length] == 0x12 && data[length + 1] == 0x34) ) {
+                    num_others++;
+                    Consume(&stream, total);
+                    continue;
+                }
+            }
+        }
+
+        Consume(&stream, 1);
+        num_skipped++;
+    }
+
+    num_skipped += stream.end - stream.start;
+    printf("%s: %llu bytes, %d Views, %d other resources, %llu bytes skipped\n",
+           path,
+           (unsigned long long)(stream.offset + stream.end - stream.start),
+           num_views,
+           num_others,
+           (unsigned long long)num_skipped);
+
+    if ( !is_stdin ) {
+        fclose(stream.file);
+    }
+    SDL_free(view);
+    SDL_free(stream.buffer);
+
+    return true;
+}
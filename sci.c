@@ -0,0 +1,458 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// SCI0 Views. Sierra's later engine stores Views with the same loop and cel
+// structure as AGI, so they are parsed into the same View representation and
+// go through the same decode, layout and output paths. The differences:
+//
+//  - Header: num_loops(2) mirror_mask(2) reserved(4) loop_offset(2)...
+//    Bit n of mirror_mask set means loop n is drawn flipped.
+//  - Loop: num_cels(2) reserved(2) cel_offset(2)..., offsets from the start
+//    of the View.
+//  - Cel: width(2) height(2) x_offset(1) y_offset(1) transparency_color(1),
+//    then RLE data.
+//  - RLE bytes are nnnn cccc (count in the high nibble, color in the low)
+//    and runs continue from one row to the next, with no row terminators.
+//  - Pixels are square.
+//
+// Games keep their resources in RESOURCE.MAP and RESOURCE.00n, optionally
+// compressed. Loose View files (patches) start with 0x80 and a header length.
+//
+
+#include "agi.h"
+
+#define SCI_TYPE_VIEW 0
+#define SCI_MAX_VOLUMES 64
+#define SCI_MAX_WIDTH 320
+#define SCI_MAX_HEIGHT 200
+
+#define LZW_MAX_BITS 12
+#define LZW_RESET 0x100
+#define LZW_END 0x101
+
+
+
+static Uint16
+Get16(const Uint8 * data, size_t size, size_t offset)
+{
+    return offset + 1 < size ? data[offset] | data[offset + 1] << 8 : 0;
+}
+
+
+
+bool
+ParseSCIView(View * view, const Uint8 * data, size_t size)
+{
+    SDL_zerop(view);
+    view->data = data;
+    view->size = size;
+    view->format = VIEW_SCI0;
+    view->pixel_width = 1;
+
+    if ( decode_timeout_ns ) {
+        view->deadline = SDL_GetTicksNS() + decode_timeout_ns;
+    }
+
+    int num_loops = Get16(data, size, 0);
+    Uint16 mirror_mask = Get16(data, size, 2);
+    if ( num_loops == 0 || num_loops > MAX_LOOPS || size < (size_t)(8 + num_loops * 2) ) {
+        return false;
+    }
+    view->num_loops = num_loops;
+
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        Loop * loop = &view->loops[i];
+        loop->offset = Get16(data, size, 8 + i * 2);
+
+        int num_cels = Get16(data, size, loop->offset);
+        if ( (size_t)loop->offset + 4 > size || num_cels > MAX_CELS ) {
+            return false;
+        }
+        loop->num_cels = num_cels;
+
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            Cel * cel = &loop->cels[j];
+            cel->header_offset = Get16(data, size, loop->offset + 4 + j * 2);
+            if ( (size_t)cel->header_offset + 7 > size ) {
+                return false;
+            }
+
+            cel->width = Get16(data, size, cel->header_offset);
+            cel->height = Get16(data, size, cel->header_offset + 2);
+            if ( cel->width > SCI_MAX_WIDTH || cel->height > SCI_MAX_HEIGHT ) {
+                return false;
+            }
+
+            cel->transparency_color = data[cel->header_offset + 6] & 0x0F;
+            cel->data_offset = cel->header_offset + 7;
+
+            // Mirrored loops share the data of the loop before them.
+            if ( i < 16 && mirror_mask & (1 << i) ) {
+                cel->is_mirrored = 1;
+                cel->unmirrored_loop_num = i - 1;
+            }
+
+            loop->total_width += cel->width;
+            loop->total_height = SDL_max(loop->total_height, cel->height);
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Decompress up to `count` rows of a cel's RLE data. A run may continue onto
+/// the next row, so the rest of it is kept for the next call. Marks the cel
+/// not ok if the data ends before every pixel is covered.
+int
+DecodeRowsSCI0(CelRows * rows, int count, Uint8 * out, int pitch)
+{
+    const View * view = rows->view;
+    const Cel * cel = rows->cel;
+    int first = rows->y;
+    int last = SDL_min(first + count, (int)cel->height);
+    int x = 0;
+
+    while ( rows->y < last ) {
+        if ( rows->run == 0 ) {
+            if ( rows->pos >= rows->end ) {
+                break;
+            }
+
+            Uint8 byte = view->data[rows->pos++];
+            rows->run = byte >> 4;
+            rows->color = byte & 0x0F;
+            continue;
+        }
+
+        Uint8 * row = out + rows->y * pitch;
+        if ( x == 0 ) {
+            memset(row, cel->transparency_color, cel->width);
+        }
+
+        int n = SDL_min(rows->run, cel->width - x);
+        memset(row + (rows->mirrored ? cel->width - x - n : x), rows->color, n);
+
+        x += n;
+        rows->run -= n;
+        if ( x == cel->width ) {
+            x = 0;
+            rows->y++;
+        }
+    }
+
+    // Out of data: leave the rest transparent.
+    if ( rows->y < last ) {
+        for ( int y = x > 0 ? rows->y + 1 : rows->y; y < last; y++ ) {
+            memset(out + y * pitch, cel->transparency_color, cel->width);
+        }
+        rows->y = last;
+        rows->ok = cel->width == 0;
+    }
+
+    return last - first;
+}
+
+
+
+/// Method 1: LZW with 9- to 12-bit codes, least significant bit first.
+static bool
+DecompressLZW(const Uint8 * src, size_t src_size, Uint8 * dst, size_t dst_size)
+{
+    Uint16 * starts = SDL_malloc((1 << LZW_MAX_BITS) * sizeof(*starts));
+    Uint16 * lengths = SDL_malloc((1 << LZW_MAX_BITS) * sizeof(*lengths));
+    size_t pos = 0;
+    size_t out = 0;
+    Uint32 bits = 0;
+    int num_bits = 0;
+    int code_bits = 9;
+    int next_code = 0x102;
+    int max_code = 0x200;
+    bool ok = false;
+
+    while ( out < dst_size ) {
+        while ( num_bits < code_bits && pos < src_size ) {
+            bits |= src[pos++] << num_bits;
+            num_bits += 8;
+        }
+        if ( num_bits < code_bits ) {
+            break;
+        }
+
+        int code = bits & ((1 << code_bits) - 1);
+        bits >>= code_bits;
+        num_bits -= code_bits;
+
+        if ( code == LZW_END ) {
+            break;
+        }
+
+        if ( code == LZW_RESET ) {
+            code_bits = 9;
+            next_code = 0x102;
+            max_code = 0x200;
+            continue;
+        }
+
+        // A code copies an earlier string plus the byte after it.
+        size_t length = 1;
+        if ( code > 0xFF ) {
+            if ( code >= next_code ) {
+                break;
+            }
+
+            length = SDL_min((size_t)lengths[code] + 1, dst_size - out);
+            for ( size_t i = 0; i < length; i++ ) {
+                dst[out + i] = dst[starts[code] + i];
+            }
+        } else {
+            dst[out] = code;
+        }
+        out += length;
+
+        if ( next_code == max_code ) {
+            if ( code_bits == LZW_MAX_BITS ) {
+                continue;
+            }
+            code_bits++;
+            max_code <<= 1;
+        }
+
+        starts[next_code] = (Uint16)(out - length);
+        lengths[next_code++] = (Uint16)length;
+    }
+
+    ok = out == dst_size;
+
+    SDL_free(starts);
+    SDL_free(lengths);
+
+    return ok;
+}
+
+
+
+/// Read bits most significant first. Returns -1 past the end of the data.
+static int
+GetBits(const Uint8 * src, size_t src_size, size_t * bit, int count)
+{
+    int value = 0;
+
+    for ( int i = 0; i < count; i++, (*bit)++ ) {
+        if ( *bit >= src_size * 8 ) {
+            return -1;
+        }
+        value = (value << 1) | ((src[*bit / 8] >> (7 - *bit % 8)) & 1);
+    }
+
+    return value;
+}
+
+
+
+/// Method 2: Huffman coding with the tree stored at the start of the data.
+/// Each node is a value byte and a byte holding the offsets, in nodes, of its
+/// left (high nibble) and right (low nibble) children; a leaf has neither. A
+/// right child offset of 0 means a literal byte follows in the bit stream.
+static bool
+DecompressHuffman(const Uint8 * src, size_t src_size, Uint8 * dst, size_t dst_size)
+{
+    if ( src_size < 2 ) {
+        return false;
+    }
+
+    int num_nodes = src[0];
+    int terminator = 0x100 | src[1];
+    const Uint8 * nodes = src + 2;
+    size_t bit = (2 + num_nodes * 2) * 8;
+    size_t out = 0;
+
+    while ( out < dst_size ) {
+        int node = 0;
+        int value = -1;
+
+        while ( value < 0 ) {
+            if ( node >= num_nodes ) {
+                return false;
+            }
+
+            Uint8 children = nodes[node * 2 + 1];
+            if ( children == 0 ) {
+                value = nodes[node * 2];
+                break;
+            }
+
+            int right = GetBits(src, src_size, &bit, 1);
+            if ( right < 0 ) {
+                return false;
+            } else if ( right && (children & 0x0F) == 0 ) {
+                int literal = GetBits(src, src_size, &bit, 8);
+                if ( literal < 0 ) {
+                    return false;
+                }
+                value = 0x100 | literal;
+            } else {
+                node += right ? children & 0x0F : children >> 4;
+            }
+        }
+
+        if ( value == terminator ) {
+            break;
+        }
+
+        dst[out++] = value & 0xFF;
+    }
+
+    return out == dst_size;
+}
+
+
+
+/// Add every View listed in an SCI0 game's RESOURCE.MAP. Each entry is six
+/// bytes: the resource type (high 5 bits) and number, then the offset (low 26
+/// bits) in the volume file named by the top 6 bits. The map ends with an
+/// entry of all 0xFF.
+bool
+CollectSCIViews(ViewList * list,
+                const char * prefix,
+                GameFileFunc load,
+                void * context)
+{
+    Source map_source;
+    char map_path[MAX_PATH_LENGTH];
+    char volume_paths[SCI_MAX_VOLUMES][MAX_PATH_LENGTH];
+    if ( !load(context, "RESOURCE.MAP", &map_source, map_path) ) {
+        return false;
+    }
+    AddSource(list, &map_source);
+
+    const Uint8 * map = map_source.data;
+    size_t map_size = map_source.size;
+    Source volumes[SCI_MAX_VOLUMES] = { 0 };
+
+    for ( size_t i = 0; i + 6 <= map_size; i += 6 ) {
+        Uint16 id = Get16(map, map_size, i);
+        Uint32 location = Get16(map, map_size, i + 2) | (Uint32)Get16(map, map_size, i + 4) << 16;
+        if ( id == 0xFFFF && location == 0xFFFFFFFF ) {
+            break;
+        }
+
+        if ( id >> 11 != SCI_TYPE_VIEW ) {
+            continue;
+        }
+
+        int number = id & 0x7FF;
+        int volume = location >> 26;
+        size_t offset = location & 0x3FFFFFF;
+
+        if ( volumes[volume].data == NULL ) {
+            char name[16];
+            snprintf(name, sizeof(name), "RESOURCE.%03d", volume);
+            if ( !load(context, name, &volumes[volume], volume_paths[volume]) ) {
+                printf("Error: could not open %s in '%s'\n", name, prefix);
+                continue;
+            }
+
+            AddSource(list, &volumes[volume]);
+        }
+
+        // Each resource has an eight-byte header: its id, the compressed
+        // size plus four, the decompressed size and the compression method.
+        const Uint8 * header = volumes[volume].data + offset;
+        size_t available = offset < volumes[volume].size ? volumes[volume].size - offset : 0;
+        Uint16 compressed_size = Get16(header, available, 2);
+        Uint16 size = Get16(header, available, 4);
+        Uint16 method = Get16(header, available, 6);
+
+        if ( available < 8 || Get16(header, available, 0) != id
+            || compressed_size < 4 || (size_t)compressed_size + 4 > available ) {
+            printf("Error: bad RESOURCE.%03d header for View %d in '%s'\n",
+                   volume, number, prefix);
+            continue;
+        }
+
+        const Uint8 * data = header + 8;
+        size_t data_size = compressed_size - 4;
+        Uint64 key = ResourceKey(volumes[volume].id, offset, 0);
+
+        if ( method != 0 ) {
+            Uint8 * decompressed = SDL_malloc(SDL_max(size, 1));
+            bool ok = false;
+            if ( method == 1 ) {
+                ok = DecompressLZW(data, data_size, decompressed, size);
+            } else if ( method == 2 ) {
+                ok = DecompressHuffman(data, data_size, decompressed, size);
+            }
+
+            if ( !ok ) {
+                printf("Error: could not decompress View %d (method %d) in '%s'\n",
+                       number, method, prefix);
+                SDL_free(decompressed);
+                continue;
+            }
+
+            data = AddBuffer(list, decompressed, size, key);
+            data_size = size;
+        }
+
+        ViewResource * view = AddView(list);
+        view->number = number;
+        view->format = VIEW_SCI0;
+        view->data = data;
+        view->size = data_size;
+        view->key = key;
+        SetViewSource(view, &volumes[volume]);
+        snprintf(view->name, sizeof(view->name), "%sVIEW.%03d", prefix, number);
+        SetViewInputs(view, map_path, volume_paths[volume]);
+    }
+
+    for ( int i = 0; i < SCI_MAX_VOLUMES; i++ ) {
+        CloseSource(&volumes[i]);
+    }
+    CloseSource(&map_source);
+
+    return true;
+}
+
+
+
+/// Check whether a loose View file is an SCI0 patch file, which starts with
+/// 0x80 (a View resource) and the length of a header to skip. If so, sets
+/// `offset` to the start of the View.
+bool
+IsSCIViewPatch(const Uint8 * data, size_t size, size_t * offset)
+{
+    if ( size < 2 || data[0] != 0x80 ) {
+        return false;
+    }
+
+    *offset = 2 + data[1];
+    View * view = SDL_malloc(sizeof(*view));
+    bool ok = *offset < size && ParseSCIView(view, data + *offset, size - *offset);
+    SDL_free(view);
+
+    return ok;
+}
@@ -0,0 +1,206 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#include "agi.h"
+
+#define SHEET_PADDING 4
+#define SHEET_LABEL_HEIGHT 10
+
+
+
+typedef struct {
+    int loop;
+    int cel;
+    int w;
+    int h;
+} Thumb;
+
+
+
+/// Choose the requested loop and cel, falling back to the first cel of the
+/// first loop when a View doesn't have them.
+static void
+ChooseThumb(const View * view, const SheetOptions * options, int shrink, Thumb * thumb)
+{
+    thumb->loop = options->loop;
+    thumb->cel = options->cel;
+
+    if ( thumb->loop < 0
+        || thumb->cel < 0
+        || thumb->loop >= view->num_loops
+        || thumb->cel >= view->loops[thumb->loop].num_cels ) {
+        thumb->loop = 0;
+        thumb->cel = 0;
+    }
+
+    const Cel * cel = &view->loops[thumb->loop].cels[thumb->cel];
+    if ( view->loops[thumb->loop].num_cels == 0 ) {
+        thumb->w = thumb->h = 0;
+    } else {
+        thumb->w = (cel->width * view->pixel_width + shrink - 1) / shrink;
+        thumb->h = (cel->height + shrink - 1) / shrink;
+    }
+}
+
+
+
+/// A View's short label: its number within its game, or its file name.
+void
+GetViewLabel(const ViewResource * resource, char * label, size_t size)
+{
+    if ( resource->number >= 0 ) {
+        snprintf(label, size, "%d", resource->number);
+    } else {
+        const char * base = strrchr(resource->name, '/');
+        snprintf(label, size, "%s", base ? base + 1 : resource->name);
+    }
+}
+
+
+
+/// Make a grid image of one cel from every View in the list, each labelled
+/// with its View number (or file name). All headers are read first to size
+/// the grid, then each thumbnail is decoded at reduced size straight into its
+/// grid cell.
+bool
+MakeContactSheet(const ViewList * list, const SheetOptions * options)
+{
+    int shrink = SDL_max(options->shrink, 1);
+    int columns = options->columns > 0 ? options->columns : 8;
+    const char * output = options->output ? options->output : "sheet.bmp";
+
+    // The sheet depends on every View's inputs.
+    const ViewResource ** resources = SDL_calloc(list->num_views, sizeof(*resources));
+    for ( int i = 0; i < list->num_views; i++ ) {
+        resources[i] = &list->views[i];
+    }
+
+    if ( IsUpToDate(output, resources, list->num_views) ) {
+        printf("%s is up to date\n", output);
+        RecordDependencies(output, resources, list->num_views);
+        SDL_free(resources);
+        return true;
+    }
+
+    View * view = SDL_malloc(sizeof(*view));
+    Thumb * thumbs = SDL_calloc(list->num_views, sizeof(*thumbs));
+    int cell_w = 3 * SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+    int cell_h = 0;
+
+    for ( int i = 0; i < list->num_views; i++ ) {
+        const ViewResource * resource = &list->views[i];
+        if ( !ParseViewResource(view, resource) ) {
+            printf("Error: '%s' is not a valid View\n", resource->name);
+            continue;
+        }
+
+        ChooseThumb(view, options, shrink, &thumbs[i]);
+        ReleaseView(view);
+        cell_w = SDL_max(cell_w, thumbs[i].w);
+        cell_h = SDL_max(cell_h, thumbs[i].h);
+    }
+
+    cell_w += SHEET_PADDING * 2;
+    cell_h += SHEET_PADDING * 2 + SHEET_LABEL_HEIGHT;
+
+    int rows = (list->num_views + columns - 1) / columns;
+    columns = SDL_min(columns, list->num_views);
+
+    SDL_Surface * sheet = SDL_CreateSurface(columns * cell_w,
+                                            rows * cell_h,
+                                            SDL_PIXELFORMAT_RGBA32);
+    if ( sheet == NULL ) {
+        fprintf(stderr, "SDL_CreateSurface failed: %s\n", SDL_GetError());
+        SDL_free(thumbs);
+        SDL_free(view);
+        SDL_free(resources);
+        return false;
+    }
+
+    const SDL_PixelFormatDetails * details = SDL_GetPixelFormatDetails(sheet->format);
+    SDL_FillSurfaceRect(sheet, NULL, SDL_MapRGBA(details, NULL, 0x20, 0x20, 0x20, 0xFF));
+
+    SDL_Renderer * renderer = SDL_CreateSoftwareRenderer(sheet);
+    if ( renderer ) {
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    }
+
+    Uint8 * pixels = SDL_malloc(MAX_CEL_WIDTH * 2 * MAX_CEL_HEIGHT);
+    int max_chars = (cell_w - SHEET_PADDING) / SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+
+    for ( int i = 0; i < list->num_views; i++ ) {
+        const ViewResource * resource = &list->views[i];
+        const Thumb * thumb = &thumbs[i];
+        int cell_x = (i % columns) * cell_w;
+        int cell_y = (i / columns) * cell_h;
+
+        if ( thumb->w > 0 && ParseViewResource(view, resource) ) {
+            const Cel * cel = &view->loops[thumb->loop].cels[thumb->cel];
+            DecodeCelReduced(view, thumb->loop, thumb->cel, shrink, pixels, thumb->w);
+            BlitCel(sheet,
+                    cell_x + (cell_w - thumb->w) / 2,
+                    cell_y + SHEET_PADDING,
+                    pixels,
+                    thumb->w,
+                    thumb->h,
+                    thumb->w,
+                    cel->transparency_color,
+                    NULL,
+                    1,
+                    1);
+            ReleaseView(view);
+        }
+
+        if ( renderer ) {
+            char label[256];
+            GetViewLabel(resource, label, sizeof(label));
+            label[SDL_min(max_chars, (int)sizeof(label) - 1)] = '\0';
+            SDL_RenderDebugText(renderer,
+                                cell_x + SHEET_PADDING,
+                                cell_y + cell_h - SHEET_PADDING - SHEET_LABEL_HEIGHT + 2,
+                                label);
+        }
+    }
+
+    if ( renderer ) {
+        SDL_RenderPresent(renderer);
+        SDL_DestroyRenderer(renderer);
+    }
+
+    bool saved = SaveImage(sheet, output, options->num_threads);
+    if ( saved ) {
+        printf("saved %s\n", output);
+        RecordDependencies(output, resources, list->num_views);
+    } else {
+        printf("Error: could not save '%s': %s\n", output, SDL_GetError());
+    }
+
+    SDL_DestroySurface(sheet);
+    SDL_free(pixels);
+    SDL_free(thumbs);
+    SDL_free(view);
+    SDL_free(resources);
+
+    return saved;
+}
@@ -0,0 +1,519 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+// Sources: the immutable bytes resources are read from.
+//
+// Files are mapped into memory where the platform allows, and read whole
+// otherwise. Everything found in them (VOL resources, files in disk images)
+// is a span of the file's bytes, so parsing and decoding never copy them.
+// Only data that has to be made while reading (decompressed resources, files
+// fragmented across a disk image) lives in memory of its own.
+//
+// Each source has an identity derived from where its bytes come from rather
+// than the bytes themselves: for files, the device, inode, size and
+// modification time, so it stays the same between runs until the file
+// changes, without reading the file to compute it. Resources are identified
+// by their source and offset, giving caches a key that is cheap to make.
+//
+// Game files are opened through a cache shared by every thread. Resources in
+// them are found by offset rather than address, and their file is only held
+// open (pinned) while a resource is being read. Unpinned files stay open in
+// case they are needed again, until the number open reaches a limit set from
+// the process's open file limit; then the least recently used are closed. A
+// corpus of any size is read with the same number of files open, and each
+// file is only opened again if it was closed in the meantime. Files are found
+// in the cache by path, and by identity when opened under another path, so
+// every reader of a file shares one entry.
+
+#include "agi.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define FNV_OFFSET 0xCBF29CE484222325ull
+#define FNV_PRIME 0x100000001B3ull
+
+#define MIN_OPEN_FILES 16
+#define MAX_OPEN_FILES 4096
+#define FILE_BUCKETS 1024
+
+struct CachedFile {
+    char * path;
+    Uint64 id;          // Identity when first opened.
+    Source source;      // The file's bytes, or no data if closed.
+    int pins;
+    CachedFile * prev;  // Open files, most recently used first.
+    CachedFile * next;
+    CachedFile * link;  // Every file in the cache.
+    CachedFile * path_chain; // Next in the same bucket of `by_path`,
+    CachedFile * id_chain;   // and of `by_id`.
+};
+
+static struct {
+    SDL_InitState init;
+    SDL_Mutex * lock;
+    CachedFile * files;
+    CachedFile * by_path[FILE_BUCKETS];
+    CachedFile * by_id[FILE_BUCKETS];
+    CachedFile * first; // Most recently used open file.
+    CachedFile * last;
+    int num_open;
+    int max_open;
+} cache;
+
+
+
+static Uint64
+HashBytes(Uint64 hash, const void * data, size_t size)
+{
+    const Uint8 * p = data;
+    for ( size_t i = 0; i < size; i++ ) {
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+
+
+static Uint64
+HashValue(Uint64 hash, Uint64 value)
+{
+    return HashBytes(hash, &value, sizeof(value));
+}
+
+
+
+/// The identity of a resource `size` bytes long at `offset` in a source.
+Uint64
+ResourceKey(Uint64 source_id, Uint64 offset, Uint64 size)
+{
+    return HashValue(HashValue(HashValue(FNV_OFFSET, source_id), offset), size);
+}
+
+
+
+/// An identity for data that has no file behind it, such as a pipe: its
+/// contents.
+Uint64
+ContentKey(const Uint8 * data, size_t size)
+{
+    return HashValue(HashBytes(FNV_OFFSET, data, size), size);
+}
+
+
+
+/// Open a file as a source, mapping it if possible.
+bool
+OpenSource(Source * source, const char * path)
+{
+    SDL_zerop(source);
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if ( fd == -1 ) {
+        return false;
+    }
+
+    struct stat st;
+    if ( fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 ) {
+        void * data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( data != MAP_FAILED ) {
+            source->data = data;
+            source->size = (size_t)st.st_size;
+            source->kind = SOURCE_MAPPED;
+            source->id = HashValue(FNV_OFFSET, (Uint64)st.st_dev);
+            source->id = HashValue(source->id, (Uint64)st.st_ino);
+            source->id = HashValue(source->id, (Uint64)st.st_size);
+            source->id = HashValue(source->id, (Uint64)st.st_mtime);
+            close(fd);
+            return true;
+        }
+    }
+    close(fd);
+#endif
+
+    size_t size;
+    Uint8 * data = SDL_LoadFile(path, &size);
+    if ( data == NULL ) {
+        return false;
+    }
+
+    SDL_PathInfo info = { 0 };
+    SDL_GetPathInfo(path, &info);
+
+    source->data = data;
+    source->size = size;
+    source->kind = SOURCE_OWNED;
+    source->id = HashBytes(FNV_OFFSET, path, strlen(path));
+    source->id = HashValue(source->id, size);
+    source->id = HashValue(source->id, (Uint64)info.modify_time);
+
+    return true;
+}
+
+
+
+/// Make a source of memory allocated with SDL_malloc, which it takes over.
+void
+OwnedSource(Source * source, void * data, size_t size, Uint64 id)
+{
+    source->data = data;
+    source->size = size;
+    source->id = id;
+    source->kind = SOURCE_OWNED;
+    source->file = NULL;
+    source->offset = 0;
+}
+
+
+
+/// Make a source of part of another, which must stay open while it is used.
+void
+SpanSource(Source * source, const Source * parent, size_t offset, size_t size)
+{
+    source->data = parent->data + offset;
+    source->size = size;
+    source->id = ResourceKey(parent->id, offset, size);
+    source->kind = SOURCE_SPAN;
+    source->file = parent->file;
+    source->offset = parent->offset + offset;
+}
+
+
+
+/// How many files the cache keeps open: half the open file limit, leaving the
+/// rest for output and the platform. Mapped files hold no descriptor once
+/// mapped, but the limit is still what the process is expected to keep in use.
+static int
+GetOpenFileLimit(void)
+{
+#ifndef _WIN32
+    struct rlimit limit;
+    if ( getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY ) {
+        rlim_t half = limit.rlim_cur / 2;
+        return (int)SDL_clamp(half, MIN_OPEN_FILES, MAX_OPEN_FILES);
+    }
+#endif
+
+    return MAX_OPEN_FILES;
+}
+
+
+
+static void
+InitCache(void)
+{
+    if ( !SDL_ShouldInit(&cache.init) ) {
+        return;
+    }
+
+    cache.lock = SDL_CreateMutex();
+    cache.max_open = GetOpenFileLimit();
+
+    SDL_SetInitialized(&cache.init, true);
+}
+
+
+
+static void
+Unlink(CachedFile * file)
+{
+    if ( file->prev ) {
+        file->prev->next = file->next;
+    } else {
+        cache.first = file->next;
+    }
+
+    if ( file->next ) {
+        file->next->prev = file->prev;
+    } else {
+        cache.last = file->prev;
+    }
+
+    file->prev = NULL;
+    file->next = NULL;
+}
+
+
+
+static void
+LinkFirst(CachedFile * file)
+{
+    file->prev = NULL;
+    file->next = cache.first;
+
+    if ( cache.first ) {
+        cache.first->prev = file;
+    } else {
+        cache.last = file;
+    }
+
+    cache.first = file;
+}
+
+
+
+/// Close the least recently used files that aren't pinned until at most
+/// `max_open` are open.
+static void
+CloseUnusedFiles(int max_open)
+{
+    CachedFile * file = cache.last;
+    while ( file && cache.num_open > max_open ) {
+        CachedFile * prev = file->prev;
+        if ( file->pins == 0 ) {
+            Unlink(file);
+            CloseSource(&file->source);
+            cache.num_open--;
+        }
+        file = prev;
+    }
+}
+
+
+
+/// Set `source` to the whole of a pinned file.
+static void
+GetFileSource(Source * source, CachedFile * file)
+{
+    source->data = file->source.data;
+    source->size = file->source.size;
+    source->id = file->id;
+    source->kind = SOURCE_CACHED;
+    source->file = file;
+    source->offset = 0;
+}
+
+
+
+static Uint32
+PathBucket(const char * path)
+{
+    return HashBytes(FNV_OFFSET, path, strlen(path)) % FILE_BUCKETS;
+}
+
+
+
+/// Find the file most recently added to the cache under `path`. The cache must
+/// be locked.
+static CachedFile *
+FindFileByPath(const char * path)
+{
+    CachedFile * file = cache.by_path[PathBucket(path)];
+    while ( file && strcmp(file->path, path) != 0 ) {
+        file = file->path_chain;
+    }
+
+    return file;
+}
+
+
+
+/// Find a file in the cache by identity. The cache must be locked.
+static CachedFile *
+FindFileByID(Uint64 id)
+{
+    CachedFile * file = cache.by_id[id % FILE_BUCKETS];
+    while ( file && file->id != id ) {
+        file = file->id_chain;
+    }
+
+    return file;
+}
+
+
+
+/// Add a closed, unpinned file to the cache. The cache must be locked.
+static CachedFile *
+AddCachedFile(const char * path, Uint64 id)
+{
+    CachedFile * file = SDL_calloc(1, sizeof(*file));
+    file->path = SDL_strdup(path);
+    file->id = id;
+
+    Uint32 bucket = PathBucket(path);
+    file->path_chain = cache.by_path[bucket];
+    cache.by_path[bucket] = file;
+    file->id_chain = cache.by_id[id % FILE_BUCKETS];
+    cache.by_id[id % FILE_BUCKETS] = file;
+    file->link = cache.files;
+    cache.files = file;
+
+    return file;
+}
+
+
+
+/// Open a file through the cache, where it stays until CloseSourceCache. The
+/// source is pinned until closed. A file already in the cache, under this path
+/// or another, is shared rather than opened again.
+bool
+OpenCachedSource(Source * source, const char * path)
+{
+    InitCache();
+
+    SDL_LockMutex(cache.lock);
+    CachedFile * file = FindFileByPath(path);
+    SDL_UnlockMutex(cache.lock);
+
+    // If it has changed since, it's added again below under its new identity.
+    if ( file && PinCachedFile(file, source) ) {
+        return true;
+    }
+
+    Source opened;
+    if ( !OpenSource(&opened, path) ) {
+        return false;
+    }
+
+    // The file may be in the cache under another path, or have been added by
+    // another thread in the meantime.
+    SDL_LockMutex(cache.lock);
+    file = FindFileByID(opened.id);
+    if ( file && file->source.data ) {
+        CloseSource(&opened);
+        Unlink(file);
+    } else {
+        CloseUnusedFiles(cache.max_open - 1);
+        if ( file == NULL ) {
+            file = AddCachedFile(path, opened.id);
+        }
+        file->source = opened;
+        cache.num_open++;
+    }
+
+    file->pins++;
+    LinkFirst(file);
+    GetFileSource(source, file);
+    SDL_UnlockMutex(cache.lock);
+
+    return true;
+}
+
+
+
+/// Pin a file in the cache, opening it again if it was closed, and set
+/// `source` to its contents. The file is opened with the cache locked, so it
+/// is only ever opened once at a time. Fails if the file has changed since it
+/// was first opened, as resources were found by their offsets in it.
+bool
+PinCachedFile(CachedFile * file, Source * source)
+{
+    SDL_LockMutex(cache.lock);
+
+    bool ok = true;
+    if ( file->source.data == NULL ) {
+        CloseUnusedFiles(cache.max_open - 1);
+
+        if ( !OpenSource(&file->source, file->path) ) {
+            SDL_SetError("could not open '%s' again", file->path);
+            ok = false;
+        } else if ( file->source.id != file->id ) {
+            CloseSource(&file->source);
+            SDL_SetError("'%s' has changed since it was read", file->path);
+            ok = false;
+        } else {
+            cache.num_open++;
+        }
+    } else {
+        Unlink(file);
+    }
+
+    if ( ok ) {
+        file->pins++;
+        LinkFirst(file);
+        GetFileSource(source, file);
+    }
+
+    SDL_UnlockMutex(cache.lock);
+
+    return ok;
+}
+
+
+
+static void
+UnpinCachedFile(CachedFile * file)
+{
+    SDL_LockMutex(cache.lock);
+    file->pins--;
+    SDL_UnlockMutex(cache.lock);
+}
+
+
+
+/// Close every file in the cache. None may be pinned.
+void
+CloseSourceCache(void)
+{
+    if ( !SDL_ShouldQuit(&cache.init) ) {
+        return;
+    }
+
+    while ( cache.files ) {
+        CachedFile * file = cache.files;
+        cache.files = file->link;
+        CloseSource(&file->source);
+        SDL_free(file->path);
+        SDL_free(file);
+    }
+
+    SDL_DestroyMutex(cache.lock);
+    cache.lock = NULL;
+    SDL_zero(cache.by_path);
+    SDL_zero(cache.by_id);
+    cache.first = NULL;
+    cache.last = NULL;
+    cache.num_open = 0;
+
+    SDL_SetInitialized(&cache.init, false);
+}
+
+
+
+void
+CloseSource(Source * source)
+{
+    if ( source->kind == SOURCE_CACHED ) {
+        UnpinCachedFile(source->file);
+    }
+
+    if ( source->kind == SOURCE_OWNED ) {
+        SDL_free((void *)source->data);
+    }
+
+#ifndef _WIN32
+    if ( source->kind == SOURCE_MAPPED ) {
+        munmap((void *)source->data, source->size);
+    }
+#endif
+
+    SDL_zerop(source);
+}
@@ -0,0 +1,353 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+//
+// Allocation and memory statistics (-stats), for sizing containers. Every
+// SDL_malloc, SDL_calloc, SDL_realloc and SDL_free, including SDL's own, goes
+// through counting wrappers installed with SDL_SetMemoryFunctions. Counts are
+// kept per thread, without locking, and per View between BeginViewStats and
+// EndViewStats, which run on the thread converting that View.
+//
+
+#include "agi.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#define MAX_STATS_THREADS 256
+#define NUM_OFFENDERS 10
+
+// Each block is preceded by a header holding its size, padded to keep the
+// block aligned for any type.
+#define HEADER_SIZE 16
+
+
+
+typedef struct {
+    Uint64 num_allocs;
+    Uint64 bytes;           // Total bytes allocated.
+    Sint64 live;            // Bytes allocated minus bytes freed.
+    Sint64 peak;            // Highest `live`.
+    Sint64 view_peak;       // Highest `live` since BeginViewStats.
+    Uint64 surface_bytes;
+} AllocCounters;
+
+
+
+typedef struct {
+    char name[256];
+    Uint64 num_allocs;
+    Uint64 bytes;
+    Sint64 peak;            // Highest live bytes above the View's start.
+    Uint64 surface_bytes;
+} ViewStats;
+
+
+
+static struct {
+    bool enabled;
+    SDL_malloc_func malloc_func;
+    SDL_calloc_func calloc_func;
+    SDL_realloc_func realloc_func;
+    SDL_free_func free_func;
+
+    AllocCounters threads[MAX_STATS_THREADS];
+    SDL_AtomicInt num_threads;
+
+    SDL_Mutex * lock;       // Guards `views`.
+    ViewStats * views;
+    int num_views;
+    int max_views;
+} stats;
+
+// This thread's counters, or NULL if it has none (yet).
+static _Thread_local AllocCounters * thread_counters;
+static _Thread_local bool thread_has_slot;
+static _Thread_local AllocCounters view_start;
+
+
+
+static AllocCounters *
+GetCounters(void)
+{
+    if ( !thread_has_slot ) {
+        thread_has_slot = true;
+        int index = SDL_AddAtomicInt(&stats.num_threads, 1);
+        if ( index < MAX_STATS_THREADS ) {
+            thread_counters = &stats.threads[index];
+        }
+    }
+
+    return thread_counters;
+}
+
+
+
+static void
+Count(Sint64 size)
+{
+    AllocCounters * counters = GetCounters();
+    if ( counters == NULL ) {
+        return;
+    }
+
+    if ( size > 0 ) {
+        counters->num_allocs++;
+        counters->bytes += size;
+    }
+
+    counters->live += size;
+    counters->peak = SDL_max(counters->peak, counters->live);
+    counters->view_peak = SDL_max(counters->view_peak, counters->live);
+}
+
+
+
+static void *
+CountingMalloc(size_t size)
+{
+    Uint8 * block = stats.malloc_func(HEADER_SIZE + size);
+    if ( block == NULL ) {
+        return NULL;
+    }
+
+    *(size_t *)block = size;
+    Count(size);
+
+    return block + HEADER_SIZE;
+}
+
+
+
+static void *
+CountingCalloc(size_t count, size_t size)
+{
+    if ( size && count > (SIZE_MAX - HEADER_SIZE) / size ) {
+        return NULL;
+    }
+
+    Uint8 * block = stats.calloc_func(1, HEADER_SIZE + count * size);
+    if ( block == NULL ) {
+        return NULL;
+    }
+
+    *(size_t *)block = count * size;
+    Count(count * size);
+
+    return block + HEADER_SIZE;
+}
+
+
+
+static void *
+CountingRealloc(void * memory, size_t size)
+{
+    Uint8 * block = memory ? (Uint8 *)memory - HEADER_SIZE : NULL;
+    size_t old_size = block ? *(size_t *)block : 0;
+
+    block = stats.realloc_func(block, HEADER_SIZE + size);
+    if ( block == NULL ) {
+        return NULL;
+    }
+
+    *(size_t *)block = size;
+    Count(-(Sint64)old_size);
+    Count(size);
+
+    return block + HEADER_SIZE;
+}
+
+
+
+static void
+CountingFree(void * memory)
+{
+    if ( memory == NULL ) {
+        return;
+    }
+
+    Uint8 * block = (Uint8 *)memory - HEADER_SIZE;
+    Count(-(Sint64)*(size_t *)block);
+    stats.free_func(block);
+}
+
+
+
+/// Start counting allocations. Must be called before anything is allocated
+/// with SDL_malloc, since blocks from the original allocator can't be freed
+/// by the counting one.
+bool
+EnableStats(void)
+{
+    SDL_GetOriginalMemoryFunctions(&stats.malloc_func,
+                                   &stats.calloc_func,
+                                   &stats.realloc_func,
+                                   &stats.free_func);
+
+    if ( !SDL_SetMemoryFunctions(CountingMalloc,
+                                 CountingCalloc,
+                                 CountingRealloc,
+                                 CountingFree) ) {
+        printf("Error: could not install allocation counters: %s\n", SDL_GetError());
+        return false;
+    }
+
+    stats.lock = SDL_CreateMutex();
+    stats.enabled = true;
+
+    return true;
+}
+
+
+
+/// Start counting for a View converted on this thread.
+void
+BeginViewStats(void)
+{
+    AllocCounters * counters = stats.enabled ? GetCounters() : NULL;
+    if ( counters ) {
+        counters->view_peak = counters->live;
+        view_start = *counters;
+    }
+}
+
+
+
+/// Count a surface made for the current View.
+void
+CountSurface(const SDL_Surface * surface)
+{
+    AllocCounters * counters = stats.enabled ? GetCounters() : NULL;
+    if ( counters && surface ) {
+        counters->surface_bytes += (Uint64)surface->pitch * surface->h;
+    }
+}
+
+
+
+/// Finish counting for the View begun on this thread.
+void
+EndViewStats(const char * name)
+{
+    AllocCounters * counters = stats.enabled ? GetCounters() : NULL;
+    if ( counters == NULL ) {
+        return;
+    }
+
+    ViewStats view = {
+        .num_allocs = counters->num_allocs - view_start.num_allocs,
+        .bytes = counters->bytes - view_start.bytes,
+        .peak = counters->view_peak - view_start.live,
+        .surface_bytes = counters->surface_bytes - view_start.surface_bytes,
+    };
+    snprintf(view.name, sizeof(view.name), "%s", name);
+
+    SDL_LockMutex(stats.lock);
+    if ( stats.num_views == stats.max_views ) {
+        stats.max_views = stats.max_views ? stats.max_views * 2 : 64;
+        stats.views = SDL_realloc(stats.views, stats.max_views * sizeof(*stats.views));
+    }
+    stats.views[stats.num_views++] = view;
+    SDL_UnlockMutex(stats.lock);
+}
+
+
+
+static int
+CompareViewPeaks(const void * a, const void * b)
+{
+    const ViewStats * view_a = a;
+    const ViewStats * view_b = b;
+
+    return (view_a->peak < view_b->peak) - (view_a->peak > view_b->peak);
+}
+
+
+
+/// Print totals, per-thread counts, the Views with the highest peak memory,
+/// and the process's peak resident set size.
+void
+PrintStats(void)
+{
+    if ( !stats.enabled ) {
+        return;
+    }
+
+    int num_threads = SDL_min(SDL_GetAtomicInt(&stats.num_threads), MAX_STATS_THREADS);
+    AllocCounters total = { 0 };
+
+    printf("\nthread   allocations          bytes     peak live  surface bytes\n");
+    for ( int i = 0; i < num_threads; i++ ) {
+        const AllocCounters * thread = &stats.threads[i];
+        printf("%6d  %12llu  %13llu  %12lld  %13llu\n",
+               i,
+               (unsigned long long)thread->num_allocs,
+               (unsigned long long)thread->bytes,
+               (long long)thread->peak,
+               (unsigned long long)thread->surface_bytes);
+
+        total.num_allocs += thread->num_allocs;
+        total.bytes += thread->bytes;
+        total.live += thread->live;
+        total.surface_bytes += thread->surface_bytes;
+    }
+
+    printf(" total  %12llu  %13llu  %12s  %13llu\n",
+           (unsigned long long)total.num_allocs,
+           (unsigned long long)total.bytes,
+           "",
+           (unsigned long long)total.surface_bytes);
+    printf("still allocated: %lld bytes\n", (long long)total.live);
+
+    SDL_LockMutex(stats.lock);
+    if ( stats.num_views > 0 ) {
+        SDL_qsort(stats.views, stats.num_views, sizeof(*stats.views), CompareViewPeaks);
+
+        printf("\nlargest Views by peak live bytes:\n");
+        printf("    peak live   allocations          bytes  surface bytes  view\n");
+        for ( int i = 0; i < SDL_min(stats.num_views, NUM_OFFENDERS); i++ ) {
+            const ViewStats * view = &stats.views[i];
+            printf("%13lld  %12llu  %13llu  %13llu  %s\n",
+                   (long long)view->peak,
+                   (unsigned long long)view->num_allocs,
+                   (unsigned long long)view->bytes,
+                   (unsigned long long)view->surface_bytes,
+                   view->name);
+        }
+    }
+    SDL_UnlockMutex(stats.lock);
+
+#ifndef _WIN32
+    struct rusage usage;
+    if ( getrusage(RUSAGE_SELF, &usage) == 0 ) {
+#ifdef __APPLE__
+        long long peak_rss = usage.ru_maxrss; // Bytes.
+#else
+        long long peak_rss = usage.ru_maxrss * 1024LL; // Kilobytes.
+#endif
+        printf("\npeak RSS: %lld bytes\n", peak_rss);
+    }
+#endif
+}
@@ -0,0 +1,318 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+// GPU texture containers: uncompressed RGBA8 DDS and KTX2 files, each with a
+// full mip chain down to 1x1, so a renderer can upload them as they are.
+//
+// Each mip level is half the size of the one before, made with a 2x2 box
+// filter weighted by alpha, so the colors of transparent pixels, which are
+// arbitrary, do not bleed into the edges of sprites.
+
+#include "agi.h"
+
+
+
+typedef struct {
+    Uint8 * pixels; // RGBA, tightly packed.
+    int w;
+    int h;
+} MipLevel;
+
+
+
+/// Make the next smaller mip level from `src`.
+static bool
+Downsample(const MipLevel * src, MipLevel * dst)
+{
+    dst->w = SDL_max(src->w / 2, 1);
+    dst->h = SDL_max(src->h / 2, 1);
+    dst->pixels = SDL_malloc((size_t)dst->w * dst->h * 4);
+    if ( dst->pixels == NULL ) {
+        return false;
+    }
+
+    for ( int y = 0; y < dst->h; y++ ) {
+        int y0 = SDL_min(y * 2, src->h - 1);
+        int y1 = SDL_min(y * 2 + 1, src->h - 1);
+
+        for ( int x = 0; x < dst->w; x++ ) {
+            int x0 = SDL_min(x * 2, src->w - 1);
+            int x1 = SDL_min(x * 2 + 1, src->w - 1);
+            const Uint8 * samples[4] = {
+                src->pixels + ((size_t)y0 * src->w + x0) * 4,
+                src->pixels + ((size_t)y0 * src->w + x1) * 4,
+                src->pixels + ((size_t)y1 * src->w + x0) * 4,
+                src->pixels + ((size_t)y1 * src->w + x1) * 4,
+            };
+
+            Uint32 alpha = 0;
+            Uint32 sums[3] = { 0 };
+            for ( int i = 0; i < 4; i++ ) {
+                alpha += samples[i][3];
+                for ( int c = 0; c < 3; c++ ) {
+                    sums[c] += samples[i][c] * samples[i][3];
+                }
+            }
+
+            Uint8 * out = dst->pixels + ((size_t)y * dst->w + x) * 4;
+            for ( int c = 0; c < 3; c++ ) {
+                out[c] = alpha ? (sums[c] + alpha / 2) / alpha : 0;
+            }
+            out[3] = (alpha + 2) / 4;
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Copy an RGBA32 surface and make its mip chain. Returns the number of
+/// levels, or 0 on failure.
+static int
+MakeMipChain(SDL_Surface * surface, MipLevel ** levels)
+{
+    if ( surface->format != SDL_PIXELFORMAT_RGBA32 ) {
+        SDL_SetError("surface is not RGBA32");
+        return 0;
+    }
+
+    int num_levels = 1;
+    for ( int size = SDL_max(surface->w, surface->h); size > 1; size /= 2 ) {
+        num_levels++;
+    }
+
+    *levels = SDL_calloc(num_levels, sizeof(MipLevel));
+    MipLevel * base = *levels;
+    if ( base == NULL ) {
+        SDL_OutOfMemory();
+        return 0;
+    }
+
+    base->w = surface->w;
+    base->h = surface->h;
+    base->pixels = SDL_malloc((size_t)surface->w * surface->h * 4);
+    if ( base->pixels == NULL ) {
+        SDL_free(*levels);
+        SDL_OutOfMemory();
+        return 0;
+    }
+
+    for ( int y = 0; y < surface->h; y++ ) {
+        memcpy(base->pixels + (size_t)y * surface->w * 4,
+               (Uint8 *)surface->pixels + y * surface->pitch,
+               (size_t)surface->w * 4);
+    }
+
+    for ( int i = 1; i < num_levels; i++ ) {
+        if ( !Downsample(&base[i - 1], &base[i]) ) {
+            for ( int j = 0; j < i; j++ ) {
+                SDL_free(base[j].pixels);
+            }
+            SDL_free(*levels);
+            SDL_OutOfMemory();
+            return 0;
+        }
+    }
+
+    return num_levels;
+}
+
+
+
+static void
+FreeMipChain(MipLevel * levels, int num_levels)
+{
+    for ( int i = 0; i < num_levels; i++ ) {
+        SDL_free(levels[i].pixels);
+    }
+    SDL_free(levels);
+}
+
+
+
+static void
+Put32(Uint8 * p, Uint32 value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+
+
+static void
+Put64(Uint8 * p, Uint64 value)
+{
+    Put32(p, (Uint32)value);
+    Put32(p + 4, (Uint32)(value >> 32));
+}
+
+
+
+#define DDS_HEADER_SIZE 128 // "DDS " and the header structure.
+
+/// Save an RGBA32 surface as a DDS file with a full mip chain.
+bool
+SaveDDS(SDL_Surface * surface, const char * path)
+{
+    MipLevel * levels;
+    int num_levels = MakeMipChain(surface, &levels);
+    if ( num_levels == 0 ) {
+        return false;
+    }
+
+    size_t size = DDS_HEADER_SIZE;
+    for ( int i = 0; i < num_levels; i++ ) {
+        size += (size_t)levels[i].w * levels[i].h * 4;
+    }
+
+    Uint8 * file = SDL_calloc(1, size);
+    if ( file == NULL ) {
+        FreeMipChain(levels, num_levels);
+        return SDL_OutOfMemory();
+    }
+
+    memcpy(file, "DDS ", 4);
+    Uint8 * header = file + 4;
+    Put32(header + 0, 124);                 // Size of the header.
+    Put32(header + 4, 0x0002100F);          // Caps, height, width, pitch, pixel
+                                            // format and mip count are set.
+    Put32(header + 8, surface->h);
+    Put32(header + 12, surface->w);
+    Put32(header + 16, surface->w * 4);     // Pitch.
+    Put32(header + 24, num_levels);
+
+    Uint8 * format = header + 72;
+    Put32(format + 0, 32);                  // Size of the pixel format.
+    Put32(format + 4, 0x41);                // RGB with alpha.
+    Put32(format + 12, 32);                 // Bits per pixel.
+    Put32(format + 16, 0x000000FF);         // Red, green, blue and alpha
+    Put32(format + 20, 0x0000FF00);         // masks, for RGBA byte order.
+    Put32(format + 24, 0x00FF0000);
+    Put32(format + 28, 0xFF000000);
+
+    Put32(header + 104, 0x00401008);        // Texture, mipmapped, complex.
+
+    size_t offset = DDS_HEADER_SIZE;
+    for ( int i = 0; i < num_levels; i++ ) {
+        size_t length = (size_t)levels[i].w * levels[i].h * 4;
+        memcpy(file + offset, levels[i].pixels, length);
+        offset += length;
+    }
+
+    bool ok = SDL_SaveFile(path, file, size);
+
+    SDL_free(file);
+    FreeMipChain(levels, num_levels);
+
+    return ok;
+}
+
+
+
+#define KTX2_HEADER_SIZE 80     // Identifier, header and index.
+#define KTX2_DFD_SIZE 92        // Total size and one basic descriptor block
+                                // with four samples.
+#define VK_FORMAT_R8G8B8A8_UNORM 37
+
+/// Save an RGBA32 surface as a KTX2 file with a full mip chain. The level
+/// index lists the largest level first, but the levels themselves are stored
+/// smallest first.
+bool
+SaveKTX2(SDL_Surface * surface, const char * path)
+{
+    MipLevel * levels;
+    int num_levels = MakeMipChain(surface, &levels);
+    if ( num_levels == 0 ) {
+        return false;
+    }
+
+    size_t dfd_offset = KTX2_HEADER_SIZE + num_levels * 24;
+    size_t size = dfd_offset + KTX2_DFD_SIZE;
+    for ( int i = 0; i < num_levels; i++ ) {
+        size += (size_t)levels[i].w * levels[i].h * 4;
+    }
+
+    Uint8 * file = SDL_calloc(1, size);
+    if ( file == NULL ) {
+        FreeMipChain(levels, num_levels);
+        return SDL_OutOfMemory();
+    }
+
+    static const Uint8 identifier[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+    };
+    memcpy(file, identifier, sizeof(identifier));
+    Put32(file + 12, VK_FORMAT_R8G8B8A8_UNORM);
+    Put32(file + 16, 1);                    // Type size.
+    Put32(file + 20, surface->w);
+    Put32(file + 24, surface->h);
+    Put32(file + 28, 0);                    // Depth.
+    Put32(file + 32, 0);                    // Layers: not an array.
+    Put32(file + 36, 1);                    // Faces.
+    Put32(file + 40, num_levels);
+    Put32(file + 44, 0);                    // No supercompression.
+    Put32(file + 48, (Uint32)dfd_offset);
+    Put32(file + 52, KTX2_DFD_SIZE);
+    // No key/value data or supercompression global data.
+
+    // The data format descriptor: a basic block for RGBA, one byte each.
+    Uint8 * dfd = file + dfd_offset;
+    Put32(dfd + 0, KTX2_DFD_SIZE);
+    Put32(dfd + 4, 0);                      // Khronos vendor, basic format.
+    Put32(dfd + 8, 2 | (88 << 16));         // Version 2, block size.
+    Put32(dfd + 12, 1 | (1 << 8) | (1 << 16)); // RGBSDA model, BT.709
+                                            // primaries, linear transfer,
+                                            // straight alpha.
+    Put32(dfd + 16, 0);                     // 1x1x1x1 texel blocks.
+    Put32(dfd + 20, 4);                     // Bytes in plane 0.
+    static const Uint8 channels[4] = { 0, 1, 2, 15 }; // R, G, B, A.
+    for ( int i = 0; i < 4; i++ ) {
+        Uint8 * sample = dfd + 28 + i * 16;
+        Put32(sample + 0, (i * 8) | (7 << 16) | (channels[i] << 24));
+        Put32(sample + 12, 255);            // Upper bound.
+    }
+
+    // Store the levels smallest first, recording each in the index.
+    size_t offset = dfd_offset + KTX2_DFD_SIZE;
+    for ( int i = num_levels - 1; i >= 0; i-- ) {
+        size_t length = (size_t)levels[i].w * levels[i].h * 4;
+        Uint8 * index = file + KTX2_HEADER_SIZE + i * 24;
+        Put64(index + 0, offset);
+        Put64(index + 8, length);
+        Put64(index + 16, length);          // Uncompressed length.
+
+        memcpy(file + offset, levels[i].pixels, length);
+        offset += length;
+    }
+
+    bool ok = SDL_SaveFile(path, file, size);
+
+    SDL_free(file);
+    FreeMipChain(levels, num_levels);
+
+    return ok;
+}
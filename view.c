@@ -0,0 +1,748 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#include "agi.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Cels at least this wide are decoded with the prefix sum kernel when the
+// kernel is KERNEL_AUTO.
+#define PREFIX_MIN_WIDTH 80
+
+DecodeKernel decode_kernel = KERNEL_AUTO;
+bool decode_bounded = false;
+Uint64 decode_timeout_ns = 0;
+
+const SDL_Color pal[16] = {
+    { 0x00, 0x00, 0x00, 0xFF },
+    { 0x00, 0x00, 0xAA, 0xFF },
+    { 0x00, 0xAA, 0x00, 0xFF },
+    { 0x00, 0xAA, 0xAA, 0xFF },
+    { 0xAA, 0x00, 0x00, 0xFF },
+    { 0xAA, 0x00, 0xAA, 0xFF },
+    { 0xAA, 0x55, 0x00, 0xFF },
+    { 0xAA, 0xAA, 0xAA, 0xFF },
+    { 0x55, 0x55, 0x55, 0xFF },
+    { 0x55, 0x55, 0xFF, 0xFF },
+    { 0x55, 0xFF, 0x55, 0xFF },
+    { 0x55, 0xFF, 0xFF, 0xFF },
+    { 0xFF, 0x55, 0x55, 0xFF },
+    { 0xFF, 0x55, 0xFF, 0xFF },
+    { 0xFF, 0xFF, 0x55, 0xFF },
+    { 0xFF, 0xFF, 0xFF, 0xFF }
+};
+
+
+
+static Uint8
+ReadByte(const View * view, size_t offset)
+{
+    return offset < view->size ? view->data[offset] : 0;
+}
+
+
+
+static Uint16
+ReadWord(const View * view, size_t offset)
+{
+    return ReadByte(view, offset) | (ReadByte(view, offset + 1) << 8);
+}
+
+
+
+/// Read the loop and cel headers of a View resource. The View keeps a pointer
+/// to `data`, which must outlive it.
+bool
+ParseView(View * view, const Uint8 * data, size_t size)
+{
+    SDL_zerop(view);
+    view->data = data;
+    view->size = size;
+    view->format = VIEW_AGI;
+    view->pixel_width = 2;
+
+    if ( decode_timeout_ns ) {
+        view->deadline = SDL_GetTicksNS() + decode_timeout_ns;
+    }
+
+    // Read the number of loops.
+    view->num_loops = ReadByte(view, 2);
+    if ( view->num_loops == 0 || size < (size_t)(5 + view->num_loops * 2) ) {
+        return false;
+    }
+
+    // Read all loop offsets, which start at byte 5.
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        view->loops[i].offset = ReadWord(view, 5 + i * 2);
+    }
+
+    // Read all loops.
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        Loop * loop = &view->loops[i];
+        if ( loop->offset >= size ) {
+            return false;
+        }
+
+        // Read the number of cels in this loop.
+        loop->num_cels = ReadByte(view, loop->offset);
+
+        // Read the cel header offsets, storing them as absolute offsets.
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            Uint16 rel_offset = ReadWord(view, loop->offset + 1 + j * 2);
+            loop->cels[j].header_offset = loop->offset + rel_offset;
+        }
+
+        // Read each cel header and store info.
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            Cel * cel = &loop->cels[j];
+
+            cel->width = ReadByte(view, cel->header_offset);
+            cel->height = ReadByte(view, cel->header_offset + 1);
+
+            Uint8 info = ReadByte(view, cel->header_offset + 2);
+            cel->is_mirrored = (info & 0x80) >> 7;
+            cel->unmirrored_loop_num = (info & 0x70) >> 4;
+            cel->transparency_color = (info & 0x0F);
+            cel->data_offset = cel->header_offset + 3;
+
+            loop->total_width += cel->width;
+            if ( cel->height > loop->total_height ) {
+                loop->total_height = cel->height;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Parse a View in whichever engine's format it was found.
+bool
+ParseViewResource(View * view, const ViewResource * resource)
+{
+    Source source;
+    if ( !LoadResource(resource, &source) ) {
+        SDL_zerop(view);
+        return false;
+    }
+
+    bool ok;
+    if ( resource->format == VIEW_SCI0 ) {
+        ok = ParseSCIView(view, source.data, source.size);
+    } else {
+        ok = ParseView(view, source.data, source.size);
+    }
+
+    view->source = source;
+    if ( !ok ) {
+        ReleaseView(view);
+    }
+
+    return ok;
+}
+
+
+
+/// Let go of the resource a View was parsed from with ParseViewResource.
+void
+ReleaseView(View * view)
+{
+    CloseSource(&view->source);
+}
+
+
+
+/// A mirrored cel is stored once and drawn flipped in every loop other than
+/// the one it was drawn for.
+bool
+CelIsMirrored(const View * view, int loop_num, const Cel * cel)
+{
+    (void)view;
+    return cel->is_mirrored && cel->unmirrored_loop_num != loop_num;
+}
+
+
+
+/// Decompress up to `count` rows of a cel's RLE data, one run at a time.
+/// Marks the cel not ok if a row is unterminated or wider than the cel.
+static int
+DecodeRowsAGI(CelRows * rows, int count, Uint8 * out, int pitch)
+{
+    const View * view = rows->view;
+    const Cel * cel = rows->cel;
+    bool mirrored = rows->mirrored;
+    size_t pos = rows->pos;
+    size_t end = rows->end;
+    bool ok = rows->ok;
+    int first = rows->y;
+    int last = SDL_min(first + count, (int)cel->height);
+
+    for ( int y = first; y < last; y++ ) {
+        Uint8 * row = out + y * pitch;
+        memset(row, cel->transparency_color, cel->width);
+
+        int x = 0;
+        bool terminated = false;
+        while ( pos < end ) {
+            Uint8 byte = view->data[pos++];
+
+            if ( byte == 0 ) {
+                terminated = true;
+                break; // End of this row.
+            }
+
+            Uint8 color = (byte >> 4) & 0x0F;
+            int run = byte & 0x0F;
+            if ( run > cel->width - x ) {
+                run = cel->width - x;
+                ok = false;
+            }
+
+            if ( mirrored ) {
+                memset(row + cel->width - x - run, color, run);
+            } else {
+                memset(row + x, color, run);
+            }
+
+            x += run;
+        }
+
+        ok &= terminated;
+    }
+
+    rows->pos = pos;
+    rows->ok = ok;
+    rows->y = last;
+
+    return last - first;
+}
+
+
+
+/// Compute the inclusive prefix sums of the run lengths (low nibbles) of 16
+/// RLE bytes. The largest possible sum is 16 * 15, so bytes don't overflow.
+static void
+PrefixSum16(const Uint8 * runs, Uint8 * sums)
+{
+#if defined(__SSE2__)
+    __m128i x = _mm_and_si128(_mm_loadu_si128((const __m128i *)runs),
+                              _mm_set1_epi8(0x0F));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+    _mm_storeu_si128((__m128i *)sums, x);
+#elif defined(__ARM_NEON)
+    uint8x16_t zero = vdupq_n_u8(0);
+    uint8x16_t x = vandq_u8(vld1q_u8(runs), vdupq_n_u8(0x0F));
+    x = vaddq_u8(x, vextq_u8(zero, x, 15));
+    x = vaddq_u8(x, vextq_u8(zero, x, 14));
+    x = vaddq_u8(x, vextq_u8(zero, x, 12));
+    x = vaddq_u8(x, vextq_u8(zero, x, 8));
+    vst1q_u8(sums, x);
+#else
+    int sum = 0;
+    for ( int i = 0; i < 16; i++ ) {
+        sum += runs[i] & 0x0F;
+        sums[i] = sum;
+    }
+#endif
+}
+
+
+
+// Sixteen bytes of each color, for writing a run as one 16-byte store.
+#define FILL(c) { c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c }
+static const Uint8 fills[16][16] = {
+    FILL(0), FILL(1), FILL(2), FILL(3), FILL(4), FILL(5), FILL(6), FILL(7),
+    FILL(8), FILL(9), FILL(10), FILL(11), FILL(12), FILL(13), FILL(14), FILL(15),
+};
+#undef FILL
+
+
+
+/// Decompress a cel's RLE data a row at a time: find the row's end, compute
+/// where every run starts with a prefix sum over the run lengths, then write
+/// the runs, which no longer depend on each other. Each run is written as a
+/// 16-byte store into a padded line buffer; the part past the end of the run
+/// is overwritten by the next run or by the transparent fill after the last.
+static bool
+DecodeCelPrefix(const View * view, int loop_num, int cel_num, size_t end, Uint8 * out, int pitch)
+{
+    const Cel * cel = &view->loops[loop_num].cels[cel_num];
+    bool mirrored = CelIsMirrored(view, loop_num, cel);
+    int width = cel->width;
+    size_t pos = cel->data_offset;
+    Uint8 line[255 + 16]; // AGI cels are at most 255 wide.
+    bool ok = true;
+
+    for ( int y = 0; y < cel->height; y++ ) {
+        Uint8 * row = out + y * pitch;
+        int start = 0;
+
+        if ( pos >= end ) {
+            ok = false;
+        } else {
+            const Uint8 * runs = view->data + pos;
+            const Uint8 * terminator = memchr(runs, 0, end - pos);
+            size_t num_runs = terminator ? (size_t)(terminator - runs) : end - pos;
+            pos += num_runs + 1;
+            ok &= terminator != NULL;
+
+            size_t i;
+            for ( i = 0; i < num_runs && start < width; i += 16 ) {
+                int n = (int)SDL_min(num_runs - i, 16);
+                Uint8 chunk[16] = { 0 };
+                Uint8 sums[16];
+                memcpy(chunk, runs + i, n);
+                PrefixSum16(chunk, sums);
+
+                for ( int k = 0; k < n; k++ ) {
+                    int x = start + sums[k] - (chunk[k] & 0x0F);
+                    if ( x < width ) {
+                        memcpy(line + x, fills[chunk[k] >> 4], 16);
+                    }
+                }
+
+                start += sums[n - 1];
+            }
+
+            ok &= i >= num_runs && start <= width;
+        }
+
+        start = SDL_min(start, width);
+        memset(line + start, cel->transparency_color, width - start);
+
+        if ( mirrored ) {
+            for ( int x = 0; x < width; x++ ) {
+                row[x] = line[width - 1 - x];
+            }
+        } else {
+            memcpy(row, line, width);
+        }
+    }
+
+    return ok;
+}
+
+
+
+/// Start decoding a cel a few rows at a time. If `decode_bounded` is set, the
+/// cel may read at most one byte per pixel plus one terminator per row.
+void
+StartCelRows(CelRows * rows, const View * view, int loop_num, int cel_num)
+{
+    const Cel * cel = &view->loops[loop_num].cels[cel_num];
+
+    SDL_zerop(rows);
+    rows->view = view;
+    rows->cel = cel;
+    rows->mirrored = CelIsMirrored(view, loop_num, cel);
+    rows->pos = cel->data_offset;
+    rows->end = view->size;
+    rows->ok = true;
+
+    if ( decode_bounded ) {
+        rows->end = SDL_min(rows->end, cel->data_offset + (size_t)cel->height * (cel->width + 1));
+    }
+}
+
+
+
+/// Decode up to `count` more rows of a cel into `out`, which holds the whole
+/// cel, with the scalar kernel. Returns the number of rows decoded.
+int
+DecodeCelRows(CelRows * rows, int count, Uint8 * out, int pitch)
+{
+    if ( rows->view->format == VIEW_SCI0 ) {
+        return DecodeRowsSCI0(rows, count, out, pitch);
+    }
+
+    return DecodeRowsAGI(rows, count, out, pitch);
+}
+
+
+
+/// Decompress a cel's RLE data into `out` as one color index per pixel (not
+/// doubled). Pixels not covered by any run are set to the cel's transparency
+/// color. If `decode_bounded` is set, false is returned if the cel's data is
+/// truncated or a row is wider than the cel.
+bool
+DecodeCel(const View * view, int loop_num, int cel_num, Uint8 * out, int pitch)
+{
+    const Cel * cel = &view->loops[loop_num].cels[cel_num];
+    CelRows rows;
+    StartCelRows(&rows, view, loop_num, cel_num);
+
+    DecodeKernel kernel = decode_kernel;
+    if ( kernel == KERNEL_AUTO ) {
+        kernel = cel->width >= PREFIX_MIN_WIDTH ? KERNEL_PREFIX : KERNEL_SCALAR;
+    }
+
+    bool ok;
+    if ( view->format == VIEW_AGI && kernel == KERNEL_PREFIX ) {
+        ok = DecodeCelPrefix(view, loop_num, cel_num, rows.end, out, pitch);
+    } else {
+        DecodeCelRows(&rows, cel->height, out, pitch);
+        ok = rows.ok;
+    }
+
+    return ok || !decode_bounded;
+}
+
+
+
+/// Decode a cel at 1/`shrink` of its displayed size (double-wide for AGI) by
+/// nearest neighbour sampling. Rows that are not sampled are skipped by
+/// scanning for their terminator, and runs that contain no sample are not
+/// written. The output is ceil(width * pixel_width / shrink) by
+/// ceil(height / shrink) pixels.
+void
+DecodeCelReduced(const View * view,
+                 int loop_num,
+                 int cel_num,
+                 int shrink,
+                 Uint8 * out,
+                 int pitch)
+{
+    const Cel * cel = &view->loops[loop_num].cels[cel_num];
+    bool mirrored = CelIsMirrored(view, loop_num, cel);
+    int display_w = cel->width * view->pixel_width;
+    int out_w = (display_w + shrink - 1) / shrink;
+    size_t pos = cel->data_offset;
+
+    if ( view->format == VIEW_SCI0 ) {
+        // SCI0 runs cross rows, so no row can be skipped: decode the whole
+        // cel and sample it.
+        Uint8 * full = SDL_malloc(SDL_max(cel->width * cel->height, 1));
+        DecodeCel(view, loop_num, cel_num, full, cel->width);
+        for ( int y = 0; y < cel->height; y += shrink ) {
+            for ( int x = 0; x < out_w; x++ ) {
+                out[(y / shrink) * pitch + x] =
+                    full[y * cel->width + x * shrink / view->pixel_width];
+            }
+        }
+        SDL_free(full);
+        return;
+    }
+
+    for ( int y = 0; y < cel->height; y++ ) {
+        if ( pos >= view->size ) {
+            pos = view->size;
+        }
+
+        if ( y % shrink != 0 ) {
+            const Uint8 * end = memchr(view->data + pos, 0, view->size - pos);
+            pos = end ? (size_t)(end - view->data) + 1 : view->size;
+            continue;
+        }
+
+        Uint8 * row = out + (y / shrink) * pitch;
+        memset(row, cel->transparency_color, out_w);
+
+        int x = 0; // In display pixels.
+        while ( pos < view->size ) {
+            Uint8 byte = view->data[pos++];
+
+            if ( byte == 0 ) {
+                break;
+            }
+
+            Uint8 color = (byte >> 4) & 0x0F;
+            int x0 = x;
+            int x1 = SDL_min(x + (byte & 0x0F) * 2, display_w);
+            x = x1;
+
+            if ( mirrored ) {
+                int flipped = display_w - x1;
+                x1 = display_w - x0;
+                x0 = flipped;
+            }
+
+            // Write each sample point, if any, that falls within this run.
+            for ( int k = (x0 + shrink - 1) / shrink; k * shrink < x1; k++ ) {
+                row[k] = color;
+            }
+        }
+    }
+}
+
+
+
+/// Draw decoded cel pixels onto an RGBA32 surface at (x, y), scaling each
+/// pixel by `x_scale` by `y_scale`. Transparent pixels are left untouched.
+/// `palette` may be NULL for the default EGA palette.
+void
+BlitCel(SDL_Surface * s,
+        int x,
+        int y,
+        const Uint8 * pixels,
+        int w,
+        int h,
+        int pitch,
+        int transparency_color,
+        const SDL_Color * palette,
+        int x_scale,
+        int y_scale)
+{
+    if ( palette == NULL ) {
+        palette = pal;
+    }
+
+    const SDL_PixelFormatDetails * details = SDL_GetPixelFormatDetails(s->format);
+    Uint32 colors[16];
+    for ( int i = 0; i < 16; i++ ) {
+        colors[i] = SDL_MapRGBA(details,
+                                NULL,
+                                palette[i].r,
+                                palette[i].g,
+                                palette[i].b,
+                                255);
+    }
+
+    for ( int row = 0; row < h * y_scale; row++ ) {
+        int dst_y = y + row;
+        if ( dst_y < 0 || dst_y >= s->h ) {
+            continue;
+        }
+
+        Uint32 * dst = (Uint32 *)((Uint8 *)s->pixels + dst_y * s->pitch);
+        const Uint8 * src = pixels + (row / y_scale) * pitch;
+
+        for ( int col = 0; col < w; col++ ) {
+            if ( src[col] == transparency_color ) {
+                continue;
+            }
+
+            for ( int k = 0; k < x_scale; k++ ) {
+                int dst_x = x + col * x_scale + k;
+                if ( dst_x >= 0 && dst_x < s->w ) {
+                    dst[dst_x] = colors[src[col] & 0x0F];
+                }
+            }
+        }
+    }
+}
+
+
+
+/// Calculate the surface size needed to accommodate all loops and cells in a
+/// View.
+static SDL_Rect
+GetSurfaceSize(const View * view)
+{
+    SDL_Rect result = { 0 };
+
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        const Loop * loop = &view->loops[i];
+
+        if ( loop->total_width > result.w ) {
+            result.w = loop->total_width;
+        }
+
+        result.h += loop->total_height;
+    }
+
+    result.w *= view->pixel_width; // Accommodate double-wide pixels.
+
+    return result;
+}
+
+
+
+/// Make a cleared surface big enough for every cel of a View. Returns NULL,
+/// with the SDL error set, if it can't be allocated.
+static SDL_Surface *
+CreateSurface(const View * view, const RenderOptions * options)
+{
+    SDL_Rect size = GetSurfaceSize(view);
+
+    SDL_Surface * s = SDL_CreateSurface(size.w * options->scale,
+                                        size.h * options->scale,
+                                        SDL_PIXELFORMAT_RGBA32);
+    if ( s == NULL ) {
+        return NULL;
+    }
+
+    // Clear the surface
+    const SDL_PixelFormatDetails * details = SDL_GetPixelFormatDetails(s->format);
+    Uint32 blank = SDL_MapRGBA(details, NULL, 0, 0, 0, 0);
+    if ( options->opaque ) {
+        SDL_Color bg = options->background;
+        blank = SDL_MapRGBA(details, NULL, bg.r, bg.g, bg.b, 0xFF);
+    }
+    SDL_FillSurfaceRect(s, NULL, blank);
+
+    return s;
+}
+
+
+
+/// Allocate one buffer for every cel of a View, leaving the pixels undefined.
+bool
+AllocateDecodedView(DecodedView * decoded, const View * view)
+{
+    SDL_zerop(decoded);
+    decoded->view = view;
+
+    size_t total = 0;
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        decoded->first_cel[i] = decoded->num_cels;
+        decoded->num_cels += view->loops[i].num_cels;
+
+        for ( int j = 0; j < view->loops[i].num_cels; j++ ) {
+            total += view->loops[i].cels[j].width * view->loops[i].cels[j].height;
+        }
+    }
+
+    decoded->pixels = SDL_malloc(SDL_max(total, 1));
+    decoded->cels = SDL_calloc(SDL_max(decoded->num_cels, 1), sizeof(Uint8 *));
+    if ( decoded->pixels == NULL || decoded->cels == NULL ) {
+        FreeDecodedView(decoded);
+        return SDL_OutOfMemory();
+    }
+
+    Uint8 * pixels = decoded->pixels;
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        for ( int j = 0; j < view->loops[i].num_cels; j++ ) {
+            const Cel * cel = &view->loops[i].cels[j];
+            decoded->cels[decoded->first_cel[i] + j] = pixels;
+            pixels += cel->width * cel->height;
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Decode every cel of a View into one buffer. Fails, with the reason set as
+/// the SDL error, if out of memory, if a cel is malformed in bounded mode, or
+/// if the View's deadline passes.
+bool
+DecodeView(DecodedView * decoded, const View * view)
+{
+    if ( !AllocateDecodedView(decoded, view) ) {
+        return false;
+    }
+
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        for ( int j = 0; j < view->loops[i].num_cels; j++ ) {
+            const Cel * cel = &view->loops[i].cels[j];
+            Uint8 * pixels = GetDecodedCel(decoded, i, j);
+
+            if ( !DecodeCel(view, i, j, pixels, cel->width) ) {
+                FreeDecodedView(decoded);
+                return SDL_SetError("loop %d cel %d: truncated or malformed data", i, j);
+            }
+
+            // Each cel's work is bounded, so checking between cels is enough.
+            if ( view->deadline && SDL_GetTicksNS() > view->deadline ) {
+                FreeDecodedView(decoded);
+                return SDL_SetError("decode time budget exceeded");
+            }
+        }
+    }
+
+    return true;
+}
+
+
+
+void
+FreeDecodedView(DecodedView * decoded)
+{
+    SDL_free(decoded->pixels);
+    SDL_free(decoded->cels);
+    SDL_zerop(decoded);
+}
+
+
+
+/// Draw every cel of a decoded View. Each loop's cels are laid out
+/// horizontally from left to right, each loop in its own row. Returns NULL,
+/// with the SDL error set, if the surface can't be allocated.
+SDL_Surface *
+RenderDecodedView(const DecodedView * decoded, const RenderOptions * options)
+{
+    const View * view = decoded->view;
+    SDL_Surface * s = CreateSurface(view, options);
+    int scale = options->scale;
+    if ( s == NULL ) {
+        return NULL;
+    }
+
+    int cel_y = 0;
+    for ( int i = 0; i < view->num_loops; i++ ) {
+        const Loop * loop = &view->loops[i];
+
+        int cel_x = 0;
+        for ( int j = 0; j < loop->num_cels; j++ ) {
+            const Cel * cel = &loop->cels[j];
+
+            BlitCel(s,
+                    cel_x,
+                    cel_y,
+                    GetDecodedCel(decoded, i, j),
+                    cel->width,
+                    cel->height,
+                    cel->width,
+                    cel->transparency_color,
+                    options->palette,
+                    view->pixel_width * scale,
+                    scale);
+
+            cel_x += cel->width * view->pixel_width * scale; // Accommodate double-wide pixels
+        }
+
+        cel_y += loop->total_height * scale;
+    }
+
+    return s;
+}
+
+
+
+/// Draw every cel of a View with the default options. Returns NULL, with the
+/// SDL error set, if the View could not be decoded or drawn.
+SDL_Surface *
+RenderView(const View * view)
+{
+    static const RenderOptions defaults = { .scale = 1 };
+    DecodedView decoded;
+
+    if ( !DecodeView(&decoded, view) ) {
+        return NULL;
+    }
+
+    SDL_Surface * s = RenderDecodedView(&decoded, &defaults);
+    FreeDecodedView(&decoded);
+
+    return s;
+}
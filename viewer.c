@@ -0,0 +1,835 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 Thomas Foster
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+// An interactive viewer: every View in the input paths in a scrolling grid,
+// each playing one loop as an animation. Only headers are read up front; a
+// cel is decoded when it first comes into view, a few rows at a time within a
+// budget per frame so that scrolling never stalls, and kept as a texture in a
+// cache bounded by memory. With -frames, the viewer scrolls through the whole
+// grid on its own and reports frame times and cache behavior, which runs
+// without a display under SDL_VIDEO_DRIVER=dummy.
+
+#include "agi.h"
+
+#define VIEWER_PADDING 4
+#define VIEWER_LABEL_HEIGHT (SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE + 4)
+#define MAX_CONTENT_WIDTH 320   // Larger cels are scaled down to fit a cell.
+#define MAX_CONTENT_HEIGHT 200
+#define MAX_ZOOM 4
+#define CEL_MS 125              // How long each cel of a loop is shown.
+#define DECODE_BUDGET_NS SDL_MS_TO_NS(4) // Decoding allowed per frame.
+#define ROWS_PER_SLICE 8        // Rows decoded between checks of the clock.
+#define TEXTURE_BUCKETS 1024
+#define BENCH_FRAME_NS (SDL_NS_PER_SECOND / 60)
+#define BENCH_SCROLL 4          // Pixels scrolled per frame with -frames.
+
+
+
+/// What the viewer needs to know about a View without keeping it parsed.
+typedef struct {
+    bool valid;
+    Uint8 pixel_width;
+    Uint8 num_loops;
+    Uint8 num_cels[MAX_LOOPS];
+} ViewSummary;
+
+
+
+typedef struct CachedTexture CachedTexture;
+
+/// A decoded cel, as a texture. `texture` is NULL for cels with no pixels.
+struct CachedTexture {
+    Uint64 key;
+    SDL_Texture * texture;
+    int w;                      // In View pixels.
+    int h;
+    size_t bytes;
+    CachedTexture * prev;       // Most recently used first.
+    CachedTexture * next;
+    CachedTexture * chain;      // Next in the same bucket.
+};
+
+typedef struct {
+    CachedTexture * buckets[TEXTURE_BUCKETS];
+    CachedTexture * first;
+    CachedTexture * last;
+    size_t bytes;
+    size_t max_bytes;
+    size_t peak_bytes;
+    int evictions;
+} TextureCache;
+
+
+
+typedef struct {
+    int view_num;
+    int loop_num;
+    int cel_num;
+    Uint64 key;
+} CelRequest;
+
+
+
+typedef struct {
+    const ViewList * list;
+    ViewSummary * summaries;
+    Uint8 * loops;              // Loop shown for each View.
+    SDL_Window * window;
+    SDL_Renderer * renderer;
+    TextureCache cache;
+
+    // Layout, in window pixels.
+    int content_w;              // Largest cel, up to MAX_CONTENT_WIDTH.
+    int content_h;
+    int zoom;
+    int cell_w;
+    int cell_h;
+    int columns;
+    int scroll;
+    int max_scroll;
+    int selected;
+    Uint64 clock_ns;            // Animation time.
+    bool paused;
+
+    // Cels wanted this frame, visible ones first, then the cels they show
+    // next.
+    CelRequest * requests;
+    int num_requests;
+
+    // The cel being decoded, from the one View kept parsed.
+    View * view;
+    int view_num;               // -1 if none.
+    bool decoding;
+    CelRequest job;
+    CelRows rows;
+    Uint8 * pixels;
+
+    // Counts for -frames.
+    int hits;
+    int misses;
+    int cels_decoded;
+} Viewer;
+
+
+
+static Uint64
+CelKey(const ViewResource * resource, int loop_num, int cel_num)
+{
+    return ResourceKey(resource->key, loop_num, cel_num);
+}
+
+
+
+static void
+UnlinkTexture(TextureCache * cache, CachedTexture * entry)
+{
+    if ( entry->prev ) {
+        entry->prev->next = entry->next;
+    } else {
+        cache->first = entry->next;
+    }
+
+    if ( entry->next ) {
+        entry->next->prev = entry->prev;
+    } else {
+        cache->last = entry->prev;
+    }
+}
+
+
+
+static void
+LinkTextureFirst(TextureCache * cache, CachedTexture * entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->first;
+    if ( cache->first ) {
+        cache->first->prev = entry;
+    } else {
+        cache->last = entry;
+    }
+    cache->first = entry;
+}
+
+
+
+/// Look up a cel's texture. If `use` is set, it becomes the most recently
+/// used.
+static CachedTexture *
+FindTexture(TextureCache * cache, Uint64 key, bool use)
+{
+    CachedTexture * entry = cache->buckets[key % TEXTURE_BUCKETS];
+    while ( entry && entry->key != key ) {
+        entry = entry->chain;
+    }
+
+    if ( entry && use && entry != cache->first ) {
+        UnlinkTexture(cache, entry);
+        LinkTextureFirst(cache, entry);
+    }
+
+    return entry;
+}
+
+
+
+static void
+EvictTexture(TextureCache * cache, CachedTexture * entry)
+{
+    CachedTexture ** link = &cache->buckets[entry->key % TEXTURE_BUCKETS];
+    while ( *link != entry ) {
+        link = &(*link)->chain;
+    }
+    *link = entry->chain;
+
+    UnlinkTexture(cache, entry);
+    cache->bytes -= entry->bytes;
+
+    if ( entry->texture ) {
+        SDL_DestroyTexture(entry->texture);
+    }
+    SDL_free(entry);
+}
+
+
+
+/// Add a cel's texture, first evicting the least recently used textures until
+/// it fits.
+static void
+InsertTexture(TextureCache * cache, Uint64 key, SDL_Texture * texture, int w, int h)
+{
+    size_t bytes = sizeof(CachedTexture) + (texture ? (size_t)w * h * 4 : 0);
+
+    while ( cache->last && cache->bytes + bytes > cache->max_bytes ) {
+        EvictTexture(cache, cache->last);
+        cache->evictions++;
+    }
+
+    CachedTexture * entry = SDL_calloc(1, sizeof(*entry));
+    entry->key = key;
+    entry->texture = texture;
+    entry->w = w;
+    entry->h = h;
+    entry->bytes = bytes;
+    entry->chain = cache->buckets[key % TEXTURE_BUCKETS];
+    cache->buckets[key % TEXTURE_BUCKETS] = entry;
+    LinkTextureFirst(cache, entry);
+
+    cache->bytes += bytes;
+    cache->peak_bytes = SDL_max(cache->peak_bytes, cache->bytes);
+}
+
+
+
+static void
+FreeTextureCache(TextureCache * cache)
+{
+    while ( cache->first ) {
+        EvictTexture(cache, cache->first);
+    }
+}
+
+
+
+/// Read every View's header once to learn its loops and cels and the size of
+/// its largest cel as displayed. Views are released again straight away: a
+/// parsed View is large, and most won't be decoded until scrolled to.
+static void
+SummarizeViews(Viewer * viewer)
+{
+    const ViewList * list = viewer->list;
+    View * view = SDL_malloc(sizeof(*view));
+
+    viewer->content_w = 3 * SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+    viewer->content_h = 0;
+
+    for ( int i = 0; i < list->num_views; i++ ) {
+        ViewSummary * summary = &viewer->summaries[i];
+        if ( !ParseViewResource(view, &list->views[i]) ) {
+            printf("Error: '%s' is not a valid View\n", list->views[i].name);
+            continue;
+        }
+
+        summary->valid = true;
+        summary->pixel_width = view->pixel_width;
+        summary->num_loops = view->num_loops;
+        for ( int j = 0; j < view->num_loops; j++ ) {
+            const Loop * loop = &view->loops[j];
+            summary->num_cels[j] = loop->num_cels;
+            for ( int k = 0; k < loop->num_cels; k++ ) {
+                int w = loop->cels[k].width * view->pixel_width;
+                viewer->content_w = SDL_max(viewer->content_w, w);
+                viewer->content_h = SDL_max(viewer->content_h, loop->cels[k].height);
+            }
+        }
+
+        ReleaseView(view);
+    }
+
+    viewer->content_w = SDL_min(viewer->content_w, MAX_CONTENT_WIDTH);
+    viewer->content_h = SDL_min(viewer->content_h, MAX_CONTENT_HEIGHT);
+    SDL_free(view);
+}
+
+
+
+/// Get the cel a View is showing now, or `ahead` cels on. Returns false if the
+/// View has nothing to show.
+static bool
+GetShownCel(const Viewer * viewer, int view_num, int ahead, int * loop_num, int * cel_num)
+{
+    const ViewSummary * summary = &viewer->summaries[view_num];
+    int loop = viewer->loops[view_num];
+
+    if ( !summary->valid || loop >= summary->num_loops || summary->num_cels[loop] == 0 ) {
+        return false;
+    }
+
+    *loop_num = loop;
+    *cel_num = (int)((viewer->clock_ns / SDL_MS_TO_NS(CEL_MS) + ahead) % summary->num_cels[loop]);
+
+    return true;
+}
+
+
+
+static void
+UpdateLayout(Viewer * viewer)
+{
+    int out_w;
+    int out_h;
+    SDL_GetRenderOutputSize(viewer->renderer, &out_w, &out_h);
+
+    viewer->cell_w = viewer->content_w * viewer->zoom + VIEWER_PADDING * 2;
+    viewer->cell_h = viewer->content_h * viewer->zoom
+                   + VIEWER_PADDING * 2
+                   + VIEWER_LABEL_HEIGHT;
+    viewer->columns = SDL_max(1, out_w / viewer->cell_w);
+
+    int rows = (viewer->list->num_views + viewer->columns - 1) / viewer->columns;
+    viewer->max_scroll = SDL_max(0, rows * viewer->cell_h - out_h);
+    viewer->scroll = SDL_clamp(viewer->scroll, 0, viewer->max_scroll);
+}
+
+
+
+/// Scroll just enough to bring the selected View fully into the window.
+static void
+ScrollToSelected(Viewer * viewer)
+{
+    int out_w;
+    int out_h;
+    SDL_GetRenderOutputSize(viewer->renderer, &out_w, &out_h);
+
+    int top = (viewer->selected / viewer->columns) * viewer->cell_h;
+    if ( top < viewer->scroll ) {
+        viewer->scroll = top;
+    } else if ( top + viewer->cell_h > viewer->scroll + out_h ) {
+        viewer->scroll = top + viewer->cell_h - out_h;
+    }
+
+    viewer->scroll = SDL_clamp(viewer->scroll, 0, viewer->max_scroll);
+}
+
+
+
+static void
+UpdateTitle(const Viewer * viewer)
+{
+    const ViewResource * resource = &viewer->list->views[viewer->selected];
+    const ViewSummary * summary = &viewer->summaries[viewer->selected];
+    char title[512];
+
+    if ( summary->valid && summary->num_loops > 0 ) {
+        int loop = viewer->loops[viewer->selected];
+        snprintf(title,
+                 sizeof(title),
+                 "%s - loop %d of %d, %d cels",
+                 resource->name,
+                 loop,
+                 summary->num_loops,
+                 summary->num_cels[loop]);
+    } else {
+        snprintf(title, sizeof(title), "%s - no cels", resource->name);
+    }
+
+    SDL_SetWindowTitle(viewer->window, title);
+}
+
+
+
+static void
+RequestCel(Viewer * viewer, int view_num, int loop_num, int cel_num, Uint64 key)
+{
+    if ( FindTexture(&viewer->cache, key, false) ) {
+        return;
+    }
+
+    CelRequest * request = &viewer->requests[viewer->num_requests++];
+    request->view_num = view_num;
+    request->loop_num = loop_num;
+    request->cel_num = cel_num;
+    request->key = key;
+}
+
+
+
+/// Draw a cel's texture centered in its cell, scaled down if it's larger than
+/// the cell's content.
+static void
+DrawCel(const Viewer * viewer, const CachedTexture * entry, int pixel_width, int x, int y)
+{
+    float w = (float)(entry->w * pixel_width);
+    float h = (float)entry->h;
+    float scale = SDL_min(1.0f, SDL_min(viewer->content_w / w, viewer->content_h / h));
+    scale *= viewer->zoom;
+
+    SDL_FRect dst;
+    dst.w = w * scale;
+    dst.h = h * scale;
+    dst.x = x + VIEWER_PADDING + (viewer->content_w * viewer->zoom - dst.w) / 2;
+    dst.y = y + VIEWER_PADDING + (viewer->content_h * viewer->zoom - dst.h) / 2;
+    SDL_RenderTexture(viewer->renderer, entry->texture, NULL, &dst);
+}
+
+
+
+/// Draw the visible part of the grid, and list the cels that it needs and
+/// that are not yet decoded.
+static void
+DrawGrid(Viewer * viewer)
+{
+    const ViewList * list = viewer->list;
+    SDL_Renderer * renderer = viewer->renderer;
+    int out_w;
+    int out_h;
+    SDL_GetRenderOutputSize(renderer, &out_w, &out_h);
+
+    SDL_SetRenderDrawColor(renderer, 0x20, 0x20, 0x20, 0xFF);
+    SDL_RenderClear(renderer);
+
+    int first = (viewer->scroll / viewer->cell_h) * viewer->columns;
+    int last = ((viewer->scroll + out_h) / viewer->cell_h + 1) * viewer->columns;
+    last = SDL_min(last, list->num_views);
+    int max_chars = (viewer->cell_w - VIEWER_PADDING) / SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+
+    viewer->num_requests = 0;
+
+    for ( int i = first; i < last; i++ ) {
+        const ViewResource * resource = &list->views[i];
+        int x = (i % viewer->columns) * viewer->cell_w;
+        int y = (i / viewer->columns) * viewer->cell_h - viewer->scroll;
+        int loop_num;
+        int cel_num;
+
+        if ( GetShownCel(viewer, i, 0, &loop_num, &cel_num) ) {
+            Uint64 key = CelKey(resource, loop_num, cel_num);
+            const CachedTexture * entry = FindTexture(&viewer->cache, key, true);
+            if ( entry ) {
+                viewer->hits++;
+                if ( entry->texture ) {
+                    DrawCel(viewer, entry, viewer->summaries[i].pixel_width, x, y);
+                }
+            } else {
+                viewer->misses++;
+                RequestCel(viewer, i, loop_num, cel_num, key);
+            }
+        }
+
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        if ( i == viewer->selected ) {
+            SDL_FRect rect = { x + 1, y + 1, viewer->cell_w - 2, viewer->cell_h - 2 };
+            SDL_RenderRect(renderer, &rect);
+        }
+
+        char label[256];
+        GetViewLabel(resource, label, sizeof(label));
+        label[SDL_min(max_chars, (int)sizeof(label) - 1)] = '\0';
+        SDL_RenderDebugText(renderer,
+                            x + VIEWER_PADDING,
+                            y + viewer->cell_h - VIEWER_PADDING - VIEWER_LABEL_HEIGHT + 2,
+                            label);
+    }
+
+    // Then the cels that the visible Views show next, so that animation
+    // doesn't wait on decoding.
+    for ( int i = first; i < last; i++ ) {
+        int loop_num;
+        int cel_num;
+        if ( GetShownCel(viewer, i, 1, &loop_num, &cel_num) ) {
+            Uint64 key = CelKey(&list->views[i], loop_num, cel_num);
+            RequestCel(viewer, i, loop_num, cel_num, key);
+        }
+    }
+}
+
+
+
+static bool
+IsRequested(const Viewer * viewer, Uint64 key)
+{
+    for ( int i = 0; i < viewer->num_requests; i++ ) {
+        if ( viewer->requests[i].key == key ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+/// Start decoding a requested cel, parsing its View if it isn't the one
+/// already parsed.
+static bool
+StartJob(Viewer * viewer, const CelRequest * request)
+{
+    if ( viewer->view_num != request->view_num ) {
+        if ( viewer->view_num >= 0 ) {
+            ReleaseView(viewer->view);
+            viewer->view_num = -1;
+        }
+
+        const ViewResource * resource = &viewer->list->views[request->view_num];
+        if ( !ParseViewResource(viewer->view, resource) ) {
+            // The file changed since the headers were read.
+            printf("Error: '%s' is not a valid View\n", resource->name);
+            viewer->summaries[request->view_num].valid = false;
+            return false;
+        }
+        viewer->view_num = request->view_num;
+    }
+
+    viewer->job = *request;
+    viewer->decoding = true;
+    StartCelRows(&viewer->rows, viewer->view, request->loop_num, request->cel_num);
+
+    return true;
+}
+
+
+
+/// Turn the decoded cel into a texture, with transparent pixels left clear.
+static void
+FinishJob(Viewer * viewer)
+{
+    const Cel * cel = viewer->rows.cel;
+    SDL_Texture * texture = NULL;
+
+    SDL_Surface * s = NULL;
+    if ( cel->width > 0 && cel->height > 0 ) {
+        s = SDL_CreateSurface(cel->width, cel->height, SDL_PIXELFORMAT_RGBA32);
+    }
+
+    if ( s ) {
+        SDL_FillSurfaceRect(s, NULL, 0);
+        BlitCel(s,
+                0,
+                0,
+                viewer->pixels,
+                cel->width,
+                cel->height,
+                cel->width,
+                cel->transparency_color,
+                NULL,
+                1,
+                1);
+        texture = SDL_CreateTextureFromSurface(viewer->renderer, s);
+        SDL_DestroySurface(s);
+    }
+
+    if ( texture ) {
+        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+    }
+
+    InsertTexture(&viewer->cache, viewer->job.key, texture, cel->width, cel->height);
+    viewer->decoding = false;
+    viewer->cels_decoded++;
+}
+
+
+
+/// Decode requested cels, in order, until the budget is spent. A cel part way
+/// through is carried on with next frame, unless it's no longer wanted.
+static void
+DecodeRequested(Viewer * viewer, Uint64 budget_ns)
+{
+    Uint64 deadline = SDL_GetTicksNS() + budget_ns;
+    int next = 0;
+
+    if ( viewer->decoding && !IsRequested(viewer, viewer->job.key) ) {
+        viewer->decoding = false;
+    }
+
+    while ( SDL_GetTicksNS() < deadline ) {
+        if ( !viewer->decoding ) {
+            // Skip cels decoded earlier this frame; a cel can be both shown
+            // now by one View and next by another.
+            while ( next < viewer->num_requests
+                   && FindTexture(&viewer->cache, viewer->requests[next].key, false) ) {
+                next++;
+            }
+
+            if ( next == viewer->num_requests ) {
+                break;
+            }
+
+            if ( !StartJob(viewer, &viewer->requests[next++]) ) {
+                continue;
+            }
+        }
+
+        const Cel * cel = viewer->rows.cel;
+        DecodeCelRows(&viewer->rows, ROWS_PER_SLICE, viewer->pixels, cel->width);
+        if ( viewer->rows.y >= cel->height ) {
+            FinishJob(viewer);
+        }
+    }
+}
+
+
+
+static void
+SelectView(Viewer * viewer, int selected)
+{
+    viewer->selected = SDL_clamp(selected, 0, viewer->list->num_views - 1);
+    ScrollToSelected(viewer);
+    UpdateTitle(viewer);
+}
+
+
+
+/// Show the selected View's next (`step` 1) or previous (-1) loop.
+static void
+ChangeLoop(Viewer * viewer, int step)
+{
+    int num_loops = viewer->summaries[viewer->selected].num_loops;
+    if ( num_loops > 0 ) {
+        Uint8 * loop = &viewer->loops[viewer->selected];
+        *loop = (*loop + step + num_loops) % num_loops;
+        UpdateTitle(viewer);
+    }
+}
+
+
+
+/// Handle pending input. Returns false once the viewer should close.
+static bool
+HandleEvents(Viewer * viewer)
+{
+    SDL_Event event;
+    int out_w;
+    int out_h;
+    SDL_GetRenderOutputSize(viewer->renderer, &out_w, &out_h);
+    int page = SDL_max(1, out_h / viewer->cell_h) * viewer->columns;
+
+    while ( SDL_PollEvent(&event) ) {
+        if ( event.type == SDL_EVENT_QUIT ) {
+            return false;
+        }
+
+        if ( event.type == SDL_EVENT_MOUSE_WHEEL ) {
+            viewer->scroll -= (int)(event.wheel.y * viewer->cell_h / 2);
+            viewer->scroll = SDL_clamp(viewer->scroll, 0, viewer->max_scroll);
+            continue;
+        }
+
+        if ( event.type != SDL_EVENT_KEY_DOWN ) {
+            continue;
+        }
+
+        int selected = viewer->selected;
+        switch ( event.key.key ) {
+            case SDLK_ESCAPE:
+            case SDLK_Q:
+                return false;
+            case SDLK_LEFT:
+                SelectView(viewer, selected - 1);
+                break;
+            case SDLK_RIGHT:
+                SelectView(viewer, selected + 1);
+                break;
+            case SDLK_UP:
+                SelectView(viewer, selected - viewer->columns);
+                break;
+            case SDLK_DOWN:
+                SelectView(viewer, selected + viewer->columns);
+                break;
+            case SDLK_PAGEUP:
+                SelectView(viewer, selected - page);
+                break;
+            case SDLK_PAGEDOWN:
+                SelectView(viewer, selected + page);
+                break;
+            case SDLK_HOME:
+                SelectView(viewer, 0);
+                break;
+            case SDLK_END:
+                SelectView(viewer, viewer->list->num_views - 1);
+                break;
+            case SDLK_TAB:
+                ChangeLoop(viewer, event.key.mod & SDL_KMOD_SHIFT ? -1 : 1);
+                break;
+            case SDLK_SPACE:
+                viewer->paused = !viewer->paused;
+                break;
+            case SDLK_EQUALS:
+            case SDLK_MINUS:
+                viewer->zoom += event.key.key == SDLK_EQUALS ? 1 : -1;
+                viewer->zoom = SDL_clamp(viewer->zoom, 1, MAX_ZOOM);
+                UpdateLayout(viewer);
+                ScrollToSelected(viewer);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return true;
+}
+
+
+
+/// Show every View in the list in a window until closed or, if
+/// `options->frames` is set, for that many frames, scrolling through the grid
+/// on a simulated 60 Hz clock and then reporting timings.
+bool
+RunViewer(const ViewList * list, const ViewerOptions * options)
+{
+    if ( list->num_views == 0 ) {
+        printf("Error: no Views to show\n");
+        return false;
+    }
+
+    if ( !SDL_Init(SDL_INIT_VIDEO) ) {
+        printf("Error: could not initialize video: %s\n", SDL_GetError());
+        return false;
+    }
+
+    Viewer viewer = { 0 };
+    viewer.list = list;
+    viewer.zoom = 1;
+    viewer.view_num = -1;
+    viewer.cache.max_bytes = options->cache_bytes;
+
+    if ( !SDL_CreateWindowAndRenderer("agiview2bmp",
+                                      960,
+                                      720,
+                                      SDL_WINDOW_RESIZABLE,
+                                      &viewer.window,
+                                      &viewer.renderer) ) {
+        printf("Error: could not create window: %s\n", SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        return false;
+    }
+
+    viewer.summaries = SDL_calloc(list->num_views, sizeof(*viewer.summaries));
+    viewer.loops = SDL_calloc(list->num_views, sizeof(*viewer.loops));
+    viewer.requests = SDL_calloc(list->num_views * 2, sizeof(*viewer.requests));
+    viewer.view = SDL_malloc(sizeof(*viewer.view));
+    viewer.pixels = SDL_malloc(MAX_CEL_WIDTH * MAX_CEL_HEIGHT);
+
+    Uint64 start = SDL_GetTicksNS();
+    SummarizeViews(&viewer);
+    Uint64 headers_ns = SDL_GetTicksNS() - start;
+
+    // Without vsync, wait out the rest of each 60 Hz frame instead.
+    bool vsync = options->frames == 0 && SDL_SetRenderVSync(viewer.renderer, 1);
+    UpdateLayout(&viewer);
+    UpdateTitle(&viewer);
+
+    Uint64 total_ns = 0;
+    Uint64 longest_ns = 0;
+    int num_frames = 0;
+    Uint64 last_ns = SDL_GetTicksNS();
+
+    for ( int frame = 0; options->frames == 0 || frame < options->frames; frame++ ) {
+        Uint64 frame_start = SDL_GetTicksNS();
+
+        if ( !HandleEvents(&viewer) ) {
+            break;
+        }
+
+        if ( options->frames ) {
+            viewer.clock_ns = frame * BENCH_FRAME_NS;
+            viewer.scroll += BENCH_SCROLL;
+            if ( viewer.scroll > viewer.max_scroll ) {
+                viewer.scroll = 0;
+            }
+        } else if ( !viewer.paused ) {
+            viewer.clock_ns += frame_start - last_ns;
+        }
+        last_ns = frame_start;
+
+        UpdateLayout(&viewer);
+        DrawGrid(&viewer);
+        SDL_RenderPresent(viewer.renderer);
+        DecodeRequested(&viewer, DECODE_BUDGET_NS);
+
+        Uint64 frame_ns = SDL_GetTicksNS() - frame_start;
+        total_ns += frame_ns;
+        longest_ns = SDL_max(longest_ns, frame_ns);
+
+        num_frames++;
+
+        if ( options->frames == 0 && !vsync && frame_ns < BENCH_FRAME_NS ) {
+            SDL_DelayNS(BENCH_FRAME_NS - frame_ns);
+        }
+    }
+
+    if ( options->frames && num_frames > 0 ) {
+        int lookups = viewer.hits + viewer.misses;
+        printf("%d Views: headers read in %.2f ms\n", list->num_views, headers_ns / 1e6);
+        printf("%d frames: mean %.3f ms, longest %.3f ms\n",
+               num_frames,
+               total_ns / 1e6 / num_frames,
+               longest_ns / 1e6);
+        printf("%d cels decoded, %d evicted, peak cache %.2f of %.2f MB\n",
+               viewer.cels_decoded,
+               viewer.cache.evictions,
+               viewer.cache.peak_bytes / 1048576.0,
+               viewer.cache.max_bytes / 1048576.0);
+        printf("%d of %d cel lookups hit (%.1f%%)\n",
+               viewer.hits,
+               lookups,
+               lookups ? viewer.hits * 100.0 / lookups : 0.0);
+    }
+
+    if ( viewer.view_num >= 0 ) {
+        ReleaseView(viewer.view);
+    }
+
+    FreeTextureCache(&viewer.cache);
+    SDL_DestroyRenderer(viewer.renderer);
+    SDL_DestroyWindow(viewer.window);
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+
+    SDL_free(viewer.pixels);
+    SDL_free(viewer.view);
+    SDL_free(viewer.requests);
+    SDL_free(viewer.loops);
+    SDL_free(viewer.summaries);
+
+    return true;
+}